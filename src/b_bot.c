@@ -17,6 +17,7 @@
 #include "p_local.h"
 #include "b_bot.h"
 #include "lua_hook.h"
+#include "k_kart.h"
 
 // If you want multiple bots, variables like this will
 // have to be stuffed in something accessible through player_t.
@@ -271,3 +272,148 @@ void B_RespawnBot(INT32 playernum)
 	P_SetScale(tails, sonic->scale);
 	tails->destscale = tails->old_scale = sonic->destscale;
 }
+
+// Kart bots are only known to the server; everyone else sees them as
+// regular players whose commands happen to come from the server.
+typedef struct
+{
+	kartbotstate_t state;
+	tic_t stucktime; // how long we've been barely moving
+	tic_t reversetime; // backing away from whatever we got stuck on
+} kartbot_t;
+
+static kartbot_t kartbots[MAXPLAYERS];
+
+kartbotstate_t B_GetKartBotState(INT32 playernum)
+{
+	if (playernum < 0 || playernum >= MAXPLAYERS)
+		return KARTBOT_NONE;
+	return kartbots[playernum].state;
+}
+
+void B_SetKartBotState(INT32 playernum, kartbotstate_t state)
+{
+	if (state == KARTBOT_NONE || kartbots[playernum].state == KARTBOT_NONE)
+		memset(&kartbots[playernum], 0, sizeof (kartbot_t));
+	kartbots[playernum].state = state;
+}
+
+void B_ClearKartBots(void)
+{
+	memset(kartbots, 0, sizeof (kartbots));
+}
+
+// Battle has no track to follow, so go after the closest opponent instead
+static mobj_t *B_KartBattleTarget(player_t *player)
+{
+	mobj_t *best = NULL;
+	fixed_t bestdist = INT32_MAX;
+	INT32 i;
+
+	for (i = 0; i < MAXPLAYERS; i++)
+	{
+		fixed_t dist;
+
+		if (!playeringame[i] || players[i].spectator || &players[i] == player)
+			continue;
+		if (!players[i].mo || P_MobjWasRemoved(players[i].mo) || players[i].mo->health <= 0)
+			continue;
+
+		dist = P_AproxDistance(players[i].mo->x - player->mo->x, players[i].mo->y - player->mo->y);
+		if (dist < bestdist)
+		{
+			best = players[i].mo;
+			bestdist = dist;
+		}
+	}
+
+	return best;
+}
+
+//
+// B_BuildKartTiccmd
+//
+// Drives toward the next checkpoint (or the nearest opponent in Battle),
+// drifting through sharp turns, using items as soon as they're rolled and
+// backing out when stuck on a wall. Spectating bots ask to join.
+//
+void B_BuildKartTiccmd(player_t *player, ticcmd_t *cmd)
+{
+	kartbot_t *bot = &kartbots[player - players];
+	mobj_t *mo = player->mo;
+	mobj_t *target;
+	angle_t angle;
+	INT32 turn = 0;
+
+	memset(cmd, 0, sizeof (ticcmd_t));
+	cmd->latency = (leveltime & 0xFF);
+
+	if (gamestate != GS_LEVEL || !mo || P_MobjWasRemoved(mo))
+		return;
+
+	angle = mo->angle;
+
+	if (player->spectator)
+	{
+		if (!(player->pflags & PF_WANTSTOJOIN) && !player->powers[pw_flashing])
+			cmd->buttons |= BT_ATTACK;
+		cmd->angleturn = (INT16)(angle >> 16);
+		return;
+	}
+
+	if (player->playerstate != PST_LIVE)
+	{
+		cmd->angleturn = (INT16)(angle >> 16);
+		return;
+	}
+
+	target = G_RaceGametype() ? K_GetNextCheckpointWaypoint(player) : B_KartBattleTarget(player);
+
+	if (target)
+		turn = (INT16)((R_PointToAngle2(mo->x, mo->y, target->x, target->y) - angle) >> 16);
+
+	if (bot->reversetime)
+	{
+		// back up, turning away from where we wanted to go
+		bot->reversetime--;
+		cmd->buttons |= BT_BRAKE;
+		turn = (turn > 0) ? -KART_FULLTURN : KART_FULLTURN;
+	}
+	else
+	{
+		cmd->buttons |= BT_ACCELERATE;
+
+		if (leveltime > starttime + TICRATE && player->speed < 4*mo->scale && !player->kartstuff[k_respawn])
+		{
+			if (++bot->stucktime > 2*TICRATE)
+			{
+				bot->stucktime = 0;
+				bot->reversetime = TICRATE;
+			}
+		}
+		else
+			bot->stucktime = 0;
+
+		// drift through anything sharper than ~20 degrees, let go once lined up
+		if (abs(turn) > KART_FULLTURN*4 && player->speed > 20*mo->scale
+			&& (!player->kartstuff[k_drift] || (player->kartstuff[k_drift] > 0) == (turn > 0)))
+			cmd->buttons |= BT_DRIFT;
+	}
+
+	if (turn > KART_FULLTURN)
+		turn = KART_FULLTURN;
+	else if (turn < -KART_FULLTURN)
+		turn = -KART_FULLTURN;
+
+	cmd->driftturn = (INT16)turn;
+
+	// tap the item button once a second, so held items get thrown too
+	if (player->kartstuff[k_itemtype] && !player->kartstuff[k_itemroulette] && (leveltime % TICRATE) == 0)
+		cmd->buttons |= BT_ATTACK;
+
+	turn = K_GetKartTurnValue(player, (INT16)turn);
+	if (player->speed > 0 || player->kartstuff[k_respawn])
+		angle += (turn << 16);
+
+	cmd->angleturn = (INT16)(angle >> 16);
+}
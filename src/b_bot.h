@@ -15,3 +15,18 @@ void B_KeysToTiccmd(mobj_t *mo, ticcmd_t *cmd, boolean forward, boolean backward
 boolean B_CheckRespawn(player_t *player);
 void B_MoveBlocked(player_t *player);
 void B_RespawnBot(INT32 playernum);
+
+// Kart bots: server-side drivers that fill player slots, for load-testing
+typedef enum
+{
+	KARTBOT_NONE = 0,
+	KARTBOT_JOINING, // XD_ADDPLAYER sent, not in game yet
+	KARTBOT_ACTIVE, // in game, name and skin sent
+	KARTBOT_LEAVING // XD_REMOVEPLAYER sent
+} kartbotstate_t;
+
+kartbotstate_t B_GetKartBotState(INT32 playernum);
+void B_SetKartBotState(INT32 playernum, kartbotstate_t state);
+void B_ClearKartBots(void);
+#define B_IsKartBot(playernum) (B_GetKartBotState(playernum) != KARTBOT_NONE)
+void B_BuildKartTiccmd(player_t *player, ticcmd_t *cmd);
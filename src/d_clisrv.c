@@ -47,6 +47,7 @@
 #include "lua_script.h"
 #include "lua_hook.h"
 #include "k_kart.h"
+#include "b_bot.h"
 #include "s_sound.h" // sfx_syfail
 #include "m_perfstats.h"
 #include "d_main.h"
@@ -206,6 +207,10 @@ consvar_t cv_httpsource = {"http_source", "", CV_SAVE, NULL, NULL, 0, NULL, NULL
 
 consvar_t cv_kicktime = {"kicktime", "10", CV_SAVE, CV_Unsigned, NULL, 0, NULL, NULL, 0, 0, NULL};
 
+// Number of server-side bots to keep in game, for load-testing. "MAX" fills every free slot.
+static CV_PossibleValue_t kartbots_cons_t[] = {{0, "MIN"}, {MAXPLAYERS, "MAX"}, {0, NULL}};
+consvar_t cv_kartbots = {"kartbots", "0", 0, kartbots_cons_t, NULL, 0, NULL, NULL, 0, 0, NULL};
+
 static inline void *G_DcpyTiccmd(void* dest, const ticcmd_t* src, const size_t n)
 {
 	const size_t d = n / sizeof(ticcmd_t);
@@ -3240,7 +3245,9 @@ void CL_RemovePlayer(INT32 playernum, INT32 reason)
 
 	demo_extradata[playernum] |= DXD_PLAYSTATE;
 
-	if (server && !demo.playback)
+	if (server && !demo.playback && B_IsKartBot(playernum))
+		B_SetKartBotState(playernum, KARTBOT_NONE); // bots share the server's node, leave it alone
+	else if (server && !demo.playback)
 	{
 		INT32 node = playernode[playernum];
 		//playerpernode[node] = 0; // It'd be better to remove them all at once, but ghosting happened, so continue to let CL_RemovePlayer do it one-by-one
@@ -3833,7 +3840,7 @@ static void Got_KickCmd(UINT8 **p, INT32 playernum)
 			banMinutes = cv_kicktime.value;
 		}
 
-		if (msg == KICK_MSG_BANNED || msg == KICK_MSG_CUSTOM_BAN || banMinutes)
+		if ((msg == KICK_MSG_BANNED || msg == KICK_MSG_CUSTOM_BAN || banMinutes) && !B_IsKartBot(pnum))
 		{
 			if (I_Ban && !I_Ban(playernode[(INT32)pnum]))
 			{
@@ -3939,7 +3946,15 @@ static void Got_KickCmd(UINT8 **p, INT32 playernum)
 			break;
 	}
 
-	if (playernode[pnum] == playernode[consoleplayer])
+	if (server && B_IsKartBot(pnum))
+	{
+		// bots sit on the server's node, so only remove the bot itself
+		buf[0] = (UINT8)pnum;
+		buf[1] = (UINT8)kickreason;
+		SendNetXCmd(XD_REMOVEPLAYER, &buf, 2);
+		B_SetKartBotState(pnum, KARTBOT_LEAVING);
+	}
+	else if (playernode[pnum] == playernode[consoleplayer])
 	{
 #ifdef DUMPCONSISTENCY
 		if (msg == KICK_MSG_CON_FAIL) SV_SavedGame();
@@ -4282,6 +4297,7 @@ void SV_ResetServer(void)
 	}
 
 	memset(player_name_changes, 0, sizeof player_name_changes);
+	B_ClearKartBots();
 
 	mynode = 0;
 	cl_packetmissed = false;
@@ -4451,7 +4467,9 @@ static void Got_AddPlayer(UINT8 **p, INT32 playernum)
 		if (node != mynode)
 			S_StartSound(NULL, sfx_join);
 
-		if (server && cv_showjoinaddress.value)
+		if (server && B_IsKartBot(newplayernum))
+			HU_AddChatText(va("\x82*Player %d has joined the game (bot)", newplayernum+1), false);
+		else if (server && cv_showjoinaddress.value)
 		{
 			const char *address;
 			if (I_GetNodeAddress && (address = I_GetNodeAddress(node)) != NULL)
@@ -4534,6 +4552,8 @@ static boolean SV_AddWaitingPlayers(void)
 			// we can't use playeringame since it is not updated here
 			for (; newplayernum < MAXPLAYERS; newplayernum++)
 			{
+				if (B_IsKartBot(newplayernum))
+					continue;
 				for (n = 0; n < MAXNETNODES; n++)
 					if (nodetoplayer[n] == newplayernum || nodetoplayer2[n] == newplayernum
 						|| nodetoplayer3[n] == newplayernum || nodetoplayer4[n] == newplayernum)
@@ -6320,6 +6340,96 @@ void SV_SpawnPlayer(INT32 playernum, INT32 x, INT32 y, angle_t angle)
 	}
 }
 
+// Queue a net command as if the given player had sent it
+static boolean SV_WritePlayerTextcmd(INT32 playernum, netxcmd_t id, const void *param, size_t nparam)
+{
+	UINT8 *textcmd = D_GetTextcmd(maketic, playernum);
+
+	if (textcmd[0]+1+nparam > MAXTEXTCMD)
+		return false;
+
+	textcmd[0]++;
+	textcmd[textcmd[0]] = (UINT8)id;
+	M_Memcpy(&textcmd[textcmd[0]+1], param, nparam);
+	textcmd[0] = (UINT8)(textcmd[0] + nparam);
+	return true;
+}
+
+// Adds or removes a bot to get closer to cv_kartbots, and gives
+// freshly joined ones a name, color and skin.
+static void SV_UpdateKartBots(void)
+{
+	UINT8 buf[MAXPLAYERNAME+3], *p;
+	INT32 i, n, count = 0, last = -1;
+
+	if (!(netgame || multiplayer) || demo.playback || modeattacking || gamestate != GS_LEVEL)
+		return;
+
+	for (i = 0; i < MAXPLAYERS; i++)
+	{
+		kartbotstate_t state = B_GetKartBotState(i);
+
+		if (state == KARTBOT_JOINING && playeringame[i])
+		{
+			p = buf;
+			WRITESTRINGN(p, va("Bot %d", i+1), MAXPLAYERNAME);
+			WRITEUINT8(p, (UINT8)M_RandomRange(1, MAXSKINCOLORS-1));
+			WRITEUINT8(p, (UINT8)M_RandomKey(numskins));
+			if (SV_WritePlayerTextcmd(i, XD_NAMEANDCOLOR, buf, p - buf))
+			{
+				B_SetKartBotState(i, KARTBOT_ACTIVE);
+				state = KARTBOT_ACTIVE;
+			}
+		}
+
+		if (state == KARTBOT_JOINING || state == KARTBOT_ACTIVE)
+		{
+			count++;
+			last = i;
+		}
+	}
+
+	if (count > cv_kartbots.value && last != -1)
+	{
+		buf[0] = (UINT8)last;
+		buf[1] = KR_LEAVE;
+		SendNetXCmd(XD_REMOVEPLAYER, &buf, 2);
+		B_SetKartBotState(last, KARTBOT_LEAVING);
+		return;
+	}
+
+	if (count >= cv_kartbots.value)
+		return;
+
+	// Same search as SV_AddWaitingPlayers; the dedicated player keeps slot 0.
+	// playernode is set as soon as a slot is handed out, so it also covers joins in flight.
+	for (i = (dedicated ? 1 : 0); i < MAXPLAYERS; i++)
+	{
+		if (playeringame[i] || playernode[i] != UINT8_MAX || B_IsKartBot(i))
+			continue;
+		for (n = 0; n < MAXNETNODES; n++)
+			if (nodetoplayer[n] == i || nodetoplayer2[n] == i
+				|| nodetoplayer3[n] == i || nodetoplayer4[n] == i)
+				break;
+		if (n == MAXNETNODES)
+			break;
+	}
+
+	if (i == MAXPLAYERS)
+		return;
+
+	// Bots borrow the server's node for bookkeeping (ping, join limits), but
+	// XD_ADDPLAYER gets a node nobody has, so no one takes the bot as their own.
+	playernode[i] = (UINT8)servernode;
+	B_SetKartBotState(i, KARTBOT_JOINING);
+
+	buf[0] = UINT8_MAX;
+	buf[1] = (UINT8)i;
+	SendNetXCmd(XD_ADDPLAYER, &buf, 2);
+
+	DEBFILE(va("Server added bot %d\n", i));
+}
+
 // create missed tic
 static void SV_Maketic(void)
 {
@@ -6350,6 +6460,16 @@ static void SV_Maketic(void)
 			}
 		}
 
+	// bots don't send anything, so make their tic here
+	for (j = 0; j < MAXPLAYERS; j++)
+		if (B_GetKartBotState(j) == KARTBOT_ACTIVE && playeringame[j])
+		{
+			B_BuildKartTiccmd(&players[j], &netcmds[maketic%TICQUEUE][j]);
+			netcmds[maketic%TICQUEUE][j].angleturn |= TICCMD_RECEIVED;
+		}
+
+	SV_UpdateKartBots();
+
 	// all tic are now proceed make the next
 	maketic++;
 }
@@ -588,7 +588,7 @@ extern consvar_t
 #ifdef SATURNSYNCH
 	cv_resynchcooldown, cv_gamestateattempts,
 #endif
-	cv_blamecfail, cv_maxsend, cv_noticedownload, cv_downloadspeed;
+	cv_blamecfail, cv_maxsend, cv_noticedownload, cv_downloadspeed, cv_kartbots;
 
 extern consvar_t cv_connectawaittime;
 
@@ -637,6 +637,16 @@ extern const char *compdate, *comptime, *comprevision, *compbranch;
 /// SRB2Kart: MIDI support is shitty and busted and we don't want it, lets throw it behind a define
 #define NO_MIDI
 
+/// Software span drawers that work out several flat offsets at once with SSE2 or NEON.
+#if defined (__SSE2__) || defined (_M_X64) || defined (__ARM_NEON)
+#define VECTORDRAWERS
+#endif
+
+/// AVX2 versions of the flat span drawers, used when the CPU running the game has AVX2.
+#if defined (VECTORDRAWERS) && defined (__GNUC__) && (defined (__x86_64__) || defined (__i386__))
+#define VECTORDRAWERS_AVX2
+#endif
+
 /// Sprite rotation
 #define ROTSPRITE
 #define ROTANGLES 72 // Needs to be a divisor of 360 (45, 60, 90, 120...)
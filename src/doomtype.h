@@ -325,6 +325,18 @@ size_t strlcpy(char *dst, const char *src, size_t siz);
 #define PUREFUNC
 #endif
 
+// Per-thread copies of globals, for state the renderer's worker threads share with the main thread
+#ifdef HAVE_THREADS
+	#if defined (_MSC_VER)
+		#define THREADLOCAL __declspec(thread)
+	#elif defined (__GNUC__)
+		#define THREADLOCAL __thread
+	#endif
+#endif
+#ifndef THREADLOCAL
+#define THREADLOCAL
+#endif
+
 /* Miscellaneous types that don't fit anywhere else (Can this be changed?) */
 
 typedef struct
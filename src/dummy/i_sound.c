@@ -19,6 +19,12 @@ void I_ShutdownSound(void){}
 
 void I_UpdateSound(void){};
 
+INT32 I_SetAudioCapture(void (*func)(const INT16 *samples, size_t numsamples))
+{
+	(void)func;
+	return 0;
+}
+
 //
 //  SFX I/O
 //
@@ -139,29 +145,24 @@ boolean I_LoadSong(char *data, size_t len)
 
 void I_UnloadSong(void)
 {
-	(void)handle;
 }
 
 boolean I_PlaySong(boolean looping)
 {
-	(void)handle;
 	(void)looping;
 	return false;
 }
 
 void I_StopSong(void)
 {
-	(void)handle;
 }
 
 void I_PauseSong(void)
 {
-	(void)handle;
 }
 
 void I_ResumeSong(void)
 {
-	(void)handle;
 }
 
 void I_SetMusicVolume(UINT8 volume)
@@ -169,6 +170,8 @@ void I_SetMusicVolume(UINT8 volume)
 	(void)volume;
 }
 
+void I_UpdateSongLagThreshold(void){}
+
 boolean I_SetSongTrack(INT32 track)
 {
 	(void)track;
@@ -188,18 +191,20 @@ void I_StopFadingSong(void)
 {
 }
 
-boolean I_FadeSongFromVolume(UINT8 target_volume, UINT8 source_volume, UINT32 ms, void (*callback)(void));
+boolean I_FadeSongFromVolume(UINT8 target_volume, UINT8 source_volume, UINT32 ms, void (*callback)(void))
 {
 	(void)target_volume;
 	(void)source_volume;
 	(void)ms;
+	(void)callback;
 	return false;
 }
 
-boolean I_FadeSong(UINT8 target_volume, UINT32 ms, void (*callback)(void));
+boolean I_FadeSong(UINT8 target_volume, UINT32 ms, void (*callback)(void))
 {
 	(void)target_volume;
 	(void)ms;
+	(void)callback;
 	return false;
 }
 
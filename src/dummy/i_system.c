@@ -1,5 +1,10 @@
 #include "../doomdef.h"
 #include "../i_system.h"
+#include "../i_time.h"
+
+#if defined (__unix__) || defined (UNIXCOMMON)
+#include <time.h>
+#endif
 
 UINT8 graphics_started = 0;
 
@@ -13,12 +18,28 @@ size_t I_GetFreeMem(size_t *total)
 
 void I_Sleep(UINT32 ms){}
 
+void I_SleepDuration(precise_t duration)
+{
+	(void)duration;
+}
+
+// A real clock, so offscreen video can time frames.
 precise_t I_GetPreciseTime(void) {
+#if defined (__unix__) || defined (UNIXCOMMON)
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (precise_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#else
 	return 0;
+#endif
 }
 
 UINT64 I_GetPrecisePrecision(void) {
+#if defined (__unix__) || defined (UNIXCOMMON)
+	return 1000000000;
+#else
 	return 1000000;
+#endif
 }
 
 void I_GetEvent(void){}
@@ -35,6 +56,16 @@ ticcmd_t *I_BaseTiccmd2(void)
 	return NULL;
 }
 
+ticcmd_t *I_BaseTiccmd3(void)
+{
+	return NULL;
+}
+
+ticcmd_t *I_BaseTiccmd4(void)
+{
+	return NULL;
+}
+
 void I_Quit(void)
 {
 	exit(0);
@@ -58,6 +89,34 @@ void I_Tactile2(FFType Type, const JoyFF_t *Effect)
 	(void)Effect;
 }
 
+void I_Tactile3(FFType Type, const JoyFF_t *Effect)
+{
+	(void)Type;
+	(void)Effect;
+}
+
+void I_Tactile4(FFType Type, const JoyFF_t *Effect)
+{
+	(void)Type;
+	(void)Effect;
+}
+
+void I_GamepadRumble(INT32 device_id, UINT16 low_strength, UINT16 high_strength, UINT32 duration)
+{
+	(void)device_id;
+	(void)low_strength;
+	(void)high_strength;
+	(void)duration;
+}
+
+void I_SetGamepadIndicatorColor(INT32 device_id, UINT8 red, UINT8 green, UINT8 blue)
+{
+	(void)device_id;
+	(void)red;
+	(void)green;
+	(void)blue;
+}
+
 void I_JoyScale(void){}
 
 void I_JoyScale2(void){}
@@ -167,7 +226,7 @@ INT32 I_ClipboardCopy(const char *data, size_t size)
 	return -1;
 }
 
-char *I_ClipboardPaste(void)
+const char *I_ClipboardPaste(void)
 {
 	return NULL;
 }
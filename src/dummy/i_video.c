@@ -1,6 +1,12 @@
 #include "../doomdef.h"
 #include "../command.h"
 #include "../i_video.h"
+#include "../i_system.h"
+#include "../m_argv.h"
+#include "../m_misc.h"
+#include "../v_video.h"
+#include "../g_game.h"
+#include "../r_main.h"
 
 rendermode_t rendermode = render_none;
 
@@ -10,24 +16,171 @@ boolean allow_fullscreen = false;
 
 consvar_t cv_vidwait = {"vid_wait", "Off", CV_SAVE, CV_OnOff, NULL, 0, NULL, NULL, 0, 0, NULL};
 
-void I_StartupGraphics(void){}
+static CV_PossibleValue_t keyboardlayout_cons_t[] = {{1,"Default US"}, {2, "Native"}, {3, "AZERTY"}, {0, NULL}};
+consvar_t cv_keyboardlayout = {"keyboardlayout", "Default US", CV_SAVE, keyboardlayout_cons_t, NULL, 0, NULL, NULL, 0, 0, NULL};
 
-void I_ShutdownGraphics(void){}
+//
+// Offscreen video
+//
+// With -offscreen, the software renderer draws into memory at the size
+// given by -width and -height, with no window. -framedump <dir> then saves
+// every frame drawn while a demo plays, along with how long it took, so
+// renderer changes can be benchmarked and pixel-diffed without a GPU.
+// -framedumpformat picks "png", "raw" (the 8-bit screen as is) or "none"
+// (timings only).
+//
+typedef enum
+{
+	FRAMEDUMP_NONE,
+	FRAMEDUMP_RAW,
+	FRAMEDUMP_PNG
+} framedumpformat_t;
+
+static boolean offscreen = false;
+static INT32 offscreenwidth = BASEVIDWIDTH, offscreenheight = BASEVIDHEIGHT;
+static UINT8 offscreenpalette[768];
+
+static const char *framedumpdir = NULL;
+static framedumpformat_t framedumpformat = FRAMEDUMP_RAW;
+static FILE *framedumptimes = NULL;
+static UINT32 framedumpcount = 0;
+static precise_t framedumplast = 0;
+
+static void I_StartFrameDump(void)
+{
+	const char *format;
+
+	if (!M_CheckParm("-framedump") || !M_IsNextParm())
+		return;
+
+	framedumpdir = M_GetNextParm();
+
+#ifdef HAVE_PNG
+	framedumpformat = FRAMEDUMP_PNG;
+#endif
+
+	if (M_CheckParm("-framedumpformat") && M_IsNextParm())
+	{
+		format = M_GetNextParm();
+		if (!stricmp(format, "none"))
+			framedumpformat = FRAMEDUMP_NONE;
+		else if (!stricmp(format, "raw"))
+			framedumpformat = FRAMEDUMP_RAW;
+#ifdef HAVE_PNG
+		else if (!stricmp(format, "png"))
+			framedumpformat = FRAMEDUMP_PNG;
+#endif
+		else
+			I_Error("-framedumpformat: unknown format %s\n", format);
+	}
+
+	I_mkdir(framedumpdir, 0755);
+	framedumptimes = fopen(va("%s" PATHSEP "frametimes.csv", framedumpdir), "w");
+	if (!framedumptimes)
+		I_Error("-framedump: can't write to %s\n", framedumpdir);
+
+	fputs("frame,gametic,frame_us,render_us,ui_us\n", framedumptimes);
+}
+
+static void I_DumpFrame(void)
+{
+	const precise_t now = I_GetPreciseTime();
+	const UINT64 precision = max(I_GetPrecisePrecision() / 1000000, 1);
+	const char *name;
+	FILE *file;
+
+	if (!framedumptimes || !demo.playback)
+	{
+		framedumplast = now;
+		return;
+	}
+
+	fprintf(framedumptimes, "%u,%u,%llu,%llu,%llu\n", framedumpcount, gametic,
+		(unsigned long long)((now - framedumplast) / precision),
+		(unsigned long long)(ps_rendercalltime.value.p / precision),
+		(unsigned long long)(ps_uitime.value.p / precision));
+	framedumplast = now;
+
+	switch (framedumpformat)
+	{
+		case FRAMEDUMP_RAW:
+			name = va("%s" PATHSEP "frame%06u.raw", framedumpdir, framedumpcount);
+			file = fopen(name, "wb");
+			if (file)
+			{
+				fwrite(screens[0], vid.width, vid.height, file);
+				fclose(file);
+			}
+			break;
+#ifdef HAVE_PNG
+		case FRAMEDUMP_PNG:
+			name = va("%s" PATHSEP "frame%06u.png", framedumpdir, framedumpcount);
+			M_SavePNG(name, screens[0], vid.width, vid.height, offscreenpalette);
+			break;
+#endif
+		default:
+			break;
+	}
+
+	framedumpcount++;
+}
+
+void I_StartupGraphics(void)
+{
+	if (dedicated || graphics_started || !M_CheckParm("-offscreen"))
+		return;
+
+	CV_RegisterVar(&cv_vidwait);
+
+	offscreen = true;
+	rendermode = render_soft;
+	I_StartFrameDump();
+	graphics_started = true;
+}
+
+void I_ShutdownGraphics(void)
+{
+	if (framedumptimes)
+	{
+		fclose(framedumptimes);
+		framedumptimes = NULL;
+	}
+
+	if (vid.buffer)
+	{
+		free(vid.buffer);
+		vid.buffer = NULL;
+	}
+
+	rendermode = render_none;
+	graphics_started = false;
+}
 
 void I_SetPalette(RGBA_t *palette)
 {
-	(void)palette;
+	size_t i;
+
+	for (i = 0; i < 256; i++)
+	{
+		offscreenpalette[i*3] = palette[i].s.red;
+		offscreenpalette[i*3+1] = palette[i].s.green;
+		offscreenpalette[i*3+2] = palette[i].s.blue;
+	}
 }
 
 INT32 VID_NumModes(void)
 {
-	return 0;
+	return offscreen ? 1 : 0;
 }
 
 INT32 VID_GetModeForSize(INT32 w, INT32 h)
 {
-	(void)w;
-	(void)h;
+	if (offscreen)
+	{
+		// The one mode is whatever size was asked for last.
+		offscreenwidth = min(max(w, BASEVIDWIDTH), MAXVIDWIDTH);
+		offscreenheight = min(max(h, BASEVIDHEIGHT), MAXVIDHEIGHT);
+	}
 	return 0;
 }
 
@@ -36,20 +189,49 @@ void VID_PrepareModeList(void){}
 INT32 VID_SetMode(INT32 modenum)
 {
 	(void)modenum;
-	return 0;
+
+	if (!offscreen)
+		return 0;
+
+	vid.modenum = 0;
+	vid.width = offscreenwidth;
+	vid.height = offscreenheight;
+	vid.bpp = 1;
+	vid.rowbytes = vid.width * vid.bpp;
+	vid.recalc = 1;
+	vid.direct = NULL;
+
+	if (vid.buffer)
+		free(vid.buffer);
+	vid.buffer = calloc(vid.rowbytes*vid.height, NUMSCREENS);
+	if (!vid.buffer)
+		I_Error("%s", M_GetText("Not enough memory for video buffer\n"));
+
+	return 1;
 }
 
 const char *VID_GetModeName(INT32 modenum)
 {
 	(void)modenum;
-	return NULL;
+
+	if (!offscreen)
+		return NULL;
+
+	return va("%dx%d", offscreenwidth, offscreenheight);
 }
 
 void I_UpdateNoBlit(void){}
 
-void I_FinishUpdate(void){}
+void I_FinishUpdate(void)
+{
+	if (offscreen)
+		I_DumpFrame();
+}
 
-void I_UpdateNoVsync(void) {}
+void I_UpdateNoVsync(void)
+{
+	I_FinishUpdate();
+}
 
 void I_WaitVBL(INT32 count)
 {
@@ -58,10 +240,24 @@ void I_WaitVBL(INT32 count)
 
 void I_ReadScreen(UINT8 *scr)
 {
-	(void)scr;
+	if (rendermode != render_soft)
+		return;
+
+	VID_BlitLinearScreen(screens[0], scr,
+		vid.width*vid.bpp, vid.height,
+		vid.rowbytes, vid.rowbytes);
+}
+
+UINT32 I_GetRefreshRate(void)
+{
+	return 60;
+}
+
+boolean I_UseNativeKeyboard(void)
+{
+	return false;
 }
 
 void I_BeginRead(void){}
 
 void I_EndRead(void){}
-
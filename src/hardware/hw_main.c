@@ -2322,6 +2322,7 @@ doaddline:
 	}
 	else
 	{
+		R_MarkInterpolatedSector(gl_backsector);
 		gl_backsector = R_FakeFlat(gl_backsector, &tempsec, NULL, NULL, true);
 
 		if (CheckClip(gl_frontsector, gl_backsector))
@@ -2822,6 +2823,8 @@ static void HWR_Subsector(size_t num)
 		line = NULL;
 	}
 
+	R_MarkInterpolatedSector(gl_frontsector);
+
 	//SoM: 4/7/2000: Test to make Boom water work in Hardware mode.
 	gl_frontsector = R_FakeFlat(gl_frontsector, &tempsec, &floorlightlevel,
 								&ceilinglightlevel, false);
@@ -4376,8 +4379,9 @@ static void HWR_AddPrecipitationSprites(void)
 	fixed_t drawdist;
 	fixed_t precipscale = cv_mobjscaleprecip.value ? mapobjectscale : FRACUNIT;
 
-	INT32 xl, xh, yl, yh, bx, by;
-	precipmobj_t *th;
+	INT32 xl, xh, yl, yh;
+	precipmobj_t *drops;
+	size_t i, numdrops;
 
 	if (current_bsp_culling_distance)
 		drawdist = min((fixed_t)current_bsp_culling_distance, (fixed_t)(cv_drawdist_precip.value) * precipscale);
@@ -4392,19 +4396,12 @@ static void HWR_AddPrecipitationSprites(void)
 
 	R_GetRenderBlockMapDimensions(drawdist, &xl, &xh, &yl, &yh);
 
-	for (bx = xl; bx <= xh; bx++)
-	{
-		for (by = yl; by <= yh; by++)
-		{
-			for (th = precipblocklinks[(by * bmapwidth) + bx]; th; th = th->bnext)
-			{
-				if (th->precipflags & PCF_INVISIBLE)
-					continue;
+	// The drops stay put until the next view generates its own,
+	// which is after these vissprites have been drawn.
+	numdrops = P_GeneratePrecipitation(xl, xh, yl, yh, &drops);
 
-				HWR_ProjectPrecipitationSprite(th);
-			}
-		}
-	}
+	for (i = 0; i < numdrops; i++)
+		HWR_ProjectPrecipitationSprite(&drops[i]);
 }
 
 // --------------------------------------------------------------------------
@@ -4780,12 +4777,6 @@ static void HWR_ProjectPrecipitationSprite(precipmobj_t *thing)
 	// uncapped/interpolation
 	interpmobjstate_t interp = {0};
 
-	// okay... this is a hack, but weather isn't networked, so it should be ok
-	if (!P_PrecipThinker(thing))
-	{
-		return;
-	}
-
 	if (cv_maxinterpdist.value)
 		dist = R_QuickCamDist(thing->x, thing->y);
 
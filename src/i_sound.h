@@ -93,6 +93,15 @@ void I_StopSound(INT32 handle);
 */
 void I_UpdateSound(void);
 
+/**	\brief	Hands everything the sound system plays to a capture function,
+	as interleaved 16-bit stereo. Called from the audio thread.
+
+	\param	func	capture function, or NULL to stop capturing
+
+	\return	the sample rate, or 0 if this sound system can't capture
+*/
+INT32 I_SetAudioCapture(void (*func)(const INT16 *samples, size_t numsamples));
+
 /**	\brief	Called by S_*() functions to see if a channel is still playing.
 
 	\param	handle	sfx handle
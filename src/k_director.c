@@ -18,6 +18,7 @@
 #include "d_netcmd.h"
 #include "p_local.h"
 #include "st_stuff.h"
+#include "k_kart.h" // K_GetFinishWaypoint
 
 #define SWITCHTIME TICRATE * 5		// cooldown between unforced switches
 #define BOREDOMTIME 3 * TICRATE / 2 // how long until players considered far apart?
@@ -91,46 +92,14 @@ void K_InitDirector(void)
 
 static fixed_t K_GetDistanceToFinish(player_t player)
 {
-	mobj_t *mo;
-	fixed_t dist = 0;
-	INT16 maxMoveCount = -1;
-	INT16 maxAngle = -1;
+	mobj_t *mo = K_GetFinishWaypoint();
 
-	if (!(mapheaderinfo[gamemap - 1]->levelflags & LF_SECTIONRACE))
-	{
-		for (mo = waypointcap; mo != NULL; mo = mo->tracer)
-		{
-			if (mo->spawnpoint->angle != 0)
-				continue;
-
-			dist = P_AproxDistance(P_AproxDistance(mo->x - player.mo->x,
-												mo->y - player.mo->y),
-							mo->z - player.mo->z) / FRACUNIT;
-
-			break;
-		}
-	}
-	else // crappy optimization weeeee
-	{
-		for (mo = waypointcap; mo != NULL; mo = mo->tracer)
-		{
-			if (mo->movecount > maxMoveCount)
-				maxMoveCount = mo->movecount;
-			if (mo->spawnpoint->angle > maxAngle)
-				maxAngle = mo->spawnpoint->angle;
-
-			if (!(mo->movecount == maxMoveCount && mo->spawnpoint->angle == maxAngle)) // sprint maps finishline waypoint is the one with highest movecount AND angle
-				continue;
-
-			dist = P_AproxDistance(P_AproxDistance(mo->x - player.mo->x,
-												   mo->y - player.mo->y),
-						  mo->z - player.mo->z) / FRACUNIT;
-
-			break;
-		}
-	}
+	if (!mo)
+		return 0;
 
-	return dist;
+	return P_AproxDistance(P_AproxDistance(mo->x - player.mo->x,
+										   mo->y - player.mo->y),
+						   mo->z - player.mo->z) / FRACUNIT;
 }
 
 static fixed_t K_GetFinishGap(INT32 leader, INT32 follower)
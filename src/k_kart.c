@@ -4755,22 +4755,60 @@ static void K_MoveHeldObjects(player_t *player)
 	}
 }
 
+// Players in game, gathered once per tic for K_FindJawzTarget instead of
+// every homing item scanning all of MAXPLAYERS. Everything else about a
+// player can change mid-tic, so it's still checked when targeting.
+static UINT8 jawzcandidates[MAXPLAYERS];
+static UINT8 numjawzcandidates;
+static tic_t jawzcandidatetic;
+static boolean jawzcandidatesvalid = false;
+
+//
+// K_ClearJawzTargets
+//
+// Forces the candidate list to be rebuilt, for when players are added.
+//
+void K_ClearJawzTargets(void)
+{
+	jawzcandidatesvalid = false;
+}
+
+static void K_GatherJawzTargets(void)
+{
+	INT32 i;
+
+	if (jawzcandidatesvalid && jawzcandidatetic == leveltime)
+		return;
+
+	numjawzcandidates = 0;
+	for (i = 0; i < MAXPLAYERS; i++)
+		if (playeringame[i])
+			jawzcandidates[numjawzcandidates++] = (UINT8)i;
+
+	jawzcandidatetic = leveltime;
+	jawzcandidatesvalid = true;
+}
+
 player_t *K_FindJawzTarget(mobj_t *actor, player_t *source)
 {
 	fixed_t best = -1;
 	player_t *wtarg = NULL;
+	const boolean race = G_RaceGametype();
+	const boolean teams = G_GametypeHasTeams();
 	INT32 i;
 
-	for (i = 0; i < MAXPLAYERS; i++)
+	K_GatherJawzTargets();
+
+	// Cheap checks come first so the angle is only worked out for
+	// players who would actually become the new best target.
+	for (i = 0; i < numjawzcandidates; i++)
 	{
 		angle_t thisang;
-		player_t *player;
+		player_t *player = &players[jawzcandidates[i]];
 
-		if (!playeringame[i])
+		if (!playeringame[jawzcandidates[i]])
 			continue;
 
-		player = &players[i];
-
 		if (player->spectator)
 			continue; // spectator
 
@@ -4785,42 +4823,41 @@ player_t *K_FindJawzTarget(mobj_t *actor, player_t *source)
 			continue;
 
 		// Don't home in on teammates.
-		if (G_GametypeHasTeams() && source->ctfteam == player->ctfteam)
+		if (teams && source->ctfteam == player->ctfteam)
 			continue;
 
 		// Invisible, don't bother
 		if (player->kartstuff[k_hyudorotimer])
 			continue;
 
-		// Find the angle, see who's got the best.
-		thisang = actor->angle - R_PointToAngle2(actor->x, actor->y, player->mo->x, player->mo->y);
-		if (thisang > ANGLE_180)
-			thisang = InvAngle(thisang);
-
 		// Jawz only go after the person directly ahead of you in race... sort of literally now!
-		if (G_RaceGametype())
+		if (race)
 		{
-			// Don't go for people who are behind you
-			if (thisang > ANGLE_67h)
-				continue;
 			// Don't pay attention to people who aren't above your position
 			if (player->kartstuff[k_position] >= source->kartstuff[k_position])
 				continue;
-			if ((best == -1) || (player->kartstuff[k_position] > best))
-			{
-				wtarg = player;
-				best = player->kartstuff[k_position];
-			}
+
+			// Wouldn't beat who we've got anyway
+			if (best != -1 && player->kartstuff[k_position] <= best)
+				continue;
+
+			// Find the angle, see who's got the best.
+			thisang = actor->angle - R_PointToAngle2(actor->x, actor->y, player->mo->x, player->mo->y);
+			if (thisang > ANGLE_180)
+				thisang = InvAngle(thisang);
+
+			// Don't go for people who are behind you
+			if (thisang > ANGLE_67h)
+				continue;
+
+			wtarg = player;
+			best = player->kartstuff[k_position];
 		}
 		else
 		{
 			fixed_t thisdist;
 			fixed_t thisavg;
 
-			// Don't go for people who are behind you
-			if (thisang > ANGLE_45)
-				continue;
-
 			// Don't pay attention to dead players
 			if (player->kartstuff[k_bumper] <= 0)
 				continue;
@@ -4834,6 +4871,19 @@ player_t *K_FindJawzTarget(mobj_t *actor, player_t *source)
 			if (thisdist > 2*RING_DIST) // Don't go for people who are too far away
 				continue;
 
+			// The angle only adds to the average, so this can't win
+			if (best != -1 && thisdist/2 >= best)
+				continue;
+
+			// Find the angle, see who's got the best.
+			thisang = actor->angle - R_PointToAngle2(actor->x, actor->y, player->mo->x, player->mo->y);
+			if (thisang > ANGLE_180)
+				thisang = InvAngle(thisang);
+
+			// Don't go for people who are behind you
+			if (thisang > ANGLE_45)
+				continue;
+
 			thisavg = (AngleFixed(thisang) + thisdist) / 2;
 
 			//CONS_Printf("got avg %d from player # %d\n", thisavg>>FRACBITS, i);
@@ -5726,6 +5776,209 @@ static void K_KartDrift(player_t *player, boolean onground)
 	else
 		player->kartstuff[k_brakedrift] = 0;
 }
+//
+// Checkpoint waypoint table
+//
+// Race positions measure how far each player is between the waypoints
+// of their last and next checkpoint. Instead of searching every waypoint
+// on the map for each pair of players every tic, the waypoints are grouped
+// by checkpoint number once per level, the first time they're needed.
+//
+
+static mobj_t **checkpointwaypoints; // every waypoint, ordered by checkpoint number
+static INT32 *checkpointstart; // index of the first waypoint of each checkpoint number
+static INT32 numcheckpoints; // highest checkpoint number + 1
+static mobj_t *finishwaypoint;
+static boolean checkpointsvalid = false;
+
+//
+// K_ClearCheckpointWaypoints
+//
+// Forget the waypoint table. Must be done whenever the waypoint list goes away.
+//
+void K_ClearCheckpointWaypoints(void)
+{
+	Z_Free(checkpointwaypoints);
+	Z_Free(checkpointstart);
+	checkpointwaypoints = NULL;
+	checkpointstart = NULL;
+	numcheckpoints = 0;
+	finishwaypoint = NULL;
+	checkpointsvalid = false;
+}
+
+static void K_BuildCheckpointWaypoints(void)
+{
+	INT32 numwaypoints = 0;
+	INT32 i;
+	INT16 maxMoveCount = -1;
+	INT16 maxAngle = -1;
+	mobj_t *mo;
+
+	K_ClearCheckpointWaypoints();
+
+	for (mo = waypointcap; mo != NULL; mo = mo->tracer)
+	{
+		if (mo->health >= numcheckpoints)
+			numcheckpoints = mo->health + 1;
+		numwaypoints++;
+	}
+
+	checkpointstart = Z_Calloc((numcheckpoints + 1) * sizeof (*checkpointstart), PU_STATIC, NULL);
+	if (numwaypoints)
+		checkpointwaypoints = Z_Malloc(numwaypoints * sizeof (*checkpointwaypoints), PU_STATIC, NULL);
+
+	// counting sort by checkpoint number; players can't be at negative ones
+	for (mo = waypointcap; mo != NULL; mo = mo->tracer)
+		if (mo->health >= 0)
+			checkpointstart[mo->health + 1]++;
+
+	for (i = 0; i < numcheckpoints; i++)
+		checkpointstart[i + 1] += checkpointstart[i];
+
+	for (mo = waypointcap; mo != NULL; mo = mo->tracer)
+	{
+		if (mo->health >= 0)
+			checkpointwaypoints[checkpointstart[mo->health]++] = mo;
+	}
+
+	// the loop above moved every start to the next one's
+	for (i = numcheckpoints; i > 0; i--)
+		checkpointstart[i] = checkpointstart[i - 1];
+	checkpointstart[0] = 0;
+
+	// Find the finish line waypoint
+	if (!(mapheaderinfo[gamemap - 1]->levelflags & LF_SECTIONRACE))
+	{
+		for (mo = waypointcap; mo != NULL; mo = mo->tracer)
+		{
+			if (mo->spawnpoint->angle != 0)
+				continue;
+
+			finishwaypoint = mo;
+			break;
+		}
+	}
+	else
+	{
+		for (mo = waypointcap; mo != NULL; mo = mo->tracer)
+		{
+			if (mo->movecount > maxMoveCount)
+				maxMoveCount = mo->movecount;
+			if (mo->spawnpoint->angle > maxAngle)
+				maxAngle = mo->spawnpoint->angle;
+
+			if (!(mo->movecount == maxMoveCount && mo->spawnpoint->angle == maxAngle)) // sprint maps finishline waypoint is the one with highest movecount AND angle
+				continue;
+
+			finishwaypoint = mo;
+			break;
+		}
+	}
+
+	checkpointsvalid = true;
+}
+
+//
+// K_GetFinishWaypoint
+//
+// Returns the waypoint marking the finish line, if there is one.
+//
+mobj_t *K_GetFinishWaypoint(void)
+{
+	if (!checkpointsvalid)
+		K_BuildCheckpointWaypoints();
+
+	return finishwaypoint;
+}
+
+// Average distance from a player to the waypoints of one checkpoint, for the player's current lap
+static fixed_t K_CheckpointDistance(player_t *player, INT32 checkpoint)
+{
+	fixed_t dist = 0;
+	INT32 count = 0;
+	INT32 i;
+
+	if (checkpoint < 0 || checkpoint >= numcheckpoints)
+		return 0;
+
+	for (i = checkpointstart[checkpoint]; i < checkpointstart[checkpoint + 1]; i++)
+	{
+		mobj_t *mo = checkpointwaypoints[i];
+
+		if (mo->movecount && mo->movecount != player->laps+1)
+			continue;
+
+		dist += P_AproxDistance(P_AproxDistance(	mo->x - player->mo->x,
+													mo->y - player->mo->y),
+													mo->z - player->mo->z) / FRACUNIT;
+		count++;
+	}
+
+	if (count > 1)
+		dist /= count;
+
+	return dist;
+}
+
+//
+// K_GetNextCheckpointWaypoint
+//
+// Closest waypoint of the checkpoint a player is heading for on their
+// current lap, or the finish line once every checkpoint has been passed.
+//
+mobj_t *K_GetNextCheckpointWaypoint(player_t *player)
+{
+	mobj_t *best = NULL;
+	fixed_t bestdist = INT32_MAX;
+	INT32 checkpoint = player->starpostnum + 1;
+	INT32 i;
+
+	if (!player->mo)
+		return NULL;
+
+	if (!checkpointsvalid)
+		K_BuildCheckpointWaypoints();
+
+	if (checkpoint < numcheckpoints)
+	{
+		for (i = checkpointstart[checkpoint]; i < checkpointstart[checkpoint + 1]; i++)
+		{
+			mobj_t *mo = checkpointwaypoints[i];
+			fixed_t dist;
+
+			if (mo->movecount && mo->movecount != player->laps+1)
+				continue;
+
+			dist = P_AproxDistance(mo->x - player->mo->x, mo->y - player->mo->y);
+			if (dist < bestdist)
+			{
+				best = mo;
+				bestdist = dist;
+			}
+		}
+	}
+
+	if (!best)
+		best = finishwaypoint;
+
+	return best;
+}
+
+//
+// K_UpdateCheckpointDistances
+//
+// Updates k_prevcheck and k_nextcheck from the player's current position.
+//
+void K_UpdateCheckpointDistances(player_t *player)
+{
+	if (!checkpointsvalid)
+		K_BuildCheckpointWaypoints();
+
+	player->kartstuff[k_prevcheck] = K_CheckpointDistance(player, player->starpostnum);
+	player->kartstuff[k_nextcheck] = K_CheckpointDistance(player, player->starpostnum + 1);
+}
+
 //
 // K_KartUpdatePosition
 //
@@ -5733,13 +5986,18 @@ void K_KartUpdatePosition(player_t *player)
 {
 	fixed_t position = 1;
 	fixed_t oldposition = player->kartstuff[k_position];
-	fixed_t i, ppcd, pncd, ipcd, incd;
-	fixed_t pmo, imo;
-	mobj_t *mo;
+	fixed_t i;
+	INT32 progress = 0;
 
 	if (player->spectator || !player->mo)
 		return;
 
+	if (G_RaceGametype())
+	{
+		progress = (player->starpostnum) + (numstarposts + 1) * player->laps;
+		K_UpdateCheckpointDistances(player);
+	}
+
 	for (i = 0; i < MAXPLAYERS; i++)
 	{
 		if (!playeringame[i] || players[i].spectator || !players[i].mo)
@@ -5747,53 +6005,19 @@ void K_KartUpdatePosition(player_t *player)
 
 		if (G_RaceGametype())
 		{
-			if ((((players[i].starpostnum) + (numstarposts + 1) * players[i].laps) >
-				((player->starpostnum) + (numstarposts + 1) * player->laps)))
-				position++;
-			else if (((players[i].starpostnum) + (numstarposts+1)*players[i].laps) ==
-				((player->starpostnum) + (numstarposts+1)*player->laps))
-			{
-				ppcd = pncd = ipcd = incd = 0;
+			INT32 iprogress;
 
-				player->kartstuff[k_prevcheck] = players[i].kartstuff[k_prevcheck] = 0;
-				player->kartstuff[k_nextcheck] = players[i].kartstuff[k_nextcheck] = 0;
+			// You're never ahead of yourself
+			if (&players[i] == player)
+				continue;
 
-				// This checks every thing on the map, and looks for MT_BOSS3WAYPOINT (the thing we're using for checkpoint wp's, for now)
-				for (mo = waypointcap; mo != NULL; mo = mo->tracer)
-				{
-					pmo = P_AproxDistance(P_AproxDistance(	mo->x - player->mo->x,
-															mo->y - player->mo->y),
-															mo->z - player->mo->z) / FRACUNIT;
-					imo = P_AproxDistance(P_AproxDistance(	mo->x - players[i].mo->x,
-															mo->y - players[i].mo->y),
-															mo->z - players[i].mo->z) / FRACUNIT;
-
-					if (mo->health == player->starpostnum && (!mo->movecount || mo->movecount == player->laps+1))
-					{
-						player->kartstuff[k_prevcheck] += pmo;
-						ppcd++;
-					}
-					if (mo->health == (player->starpostnum + 1) && (!mo->movecount || mo->movecount == player->laps+1))
-					{
-						player->kartstuff[k_nextcheck] += pmo;
-						pncd++;
-					}
-					if (mo->health == players[i].starpostnum && (!mo->movecount || mo->movecount == players[i].laps+1))
-					{
-						players[i].kartstuff[k_prevcheck] += imo;
-						ipcd++;
-					}
-					if (mo->health == (players[i].starpostnum + 1) && (!mo->movecount || mo->movecount == players[i].laps+1))
-					{
-						players[i].kartstuff[k_nextcheck] += imo;
-						incd++;
-					}
-				}
+			iprogress = (players[i].starpostnum) + (numstarposts + 1) * players[i].laps;
 
-				if (ppcd > 1) player->kartstuff[k_prevcheck] /= ppcd;
-				if (pncd > 1) player->kartstuff[k_nextcheck] /= pncd;
-				if (ipcd > 1) players[i].kartstuff[k_prevcheck] /= ipcd;
-				if (incd > 1) players[i].kartstuff[k_nextcheck] /= incd;
+			if (iprogress > progress)
+				position++;
+			else if (iprogress == progress)
+			{
+				K_UpdateCheckpointDistances(&players[i]);
 
 				if ((players[i].kartstuff[k_nextcheck] > 0 || player->kartstuff[k_nextcheck] > 0) && !player->exiting)
 				{
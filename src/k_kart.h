@@ -67,10 +67,15 @@ void K_KillBananaChain(mobj_t *banana, mobj_t *inflictor, mobj_t *source);
 void K_UpdateHnextList(player_t *player, boolean clean);
 void K_DropHnextList(player_t *player);
 void K_RepairOrbitChain(mobj_t *orbit);
+void K_ClearJawzTargets(void);
 player_t *K_FindJawzTarget(mobj_t *actor, player_t *source);
 boolean K_CheckPlayersRespawnColliding(INT32 playernum, fixed_t x, fixed_t y);
 INT16 K_GetKartTurnValue(player_t *player, INT16 turnvalue);
 INT32 K_GetKartDriftSparkValue(player_t *player);
+void K_ClearCheckpointWaypoints(void);
+mobj_t *K_GetFinishWaypoint(void);
+mobj_t *K_GetNextCheckpointWaypoint(player_t *player);
+void K_UpdateCheckpointDistances(player_t *player);
 void K_KartUpdatePosition(player_t *player);
 void K_DropItems(player_t *player);
 void K_DropRocketSneaker(player_t *player);
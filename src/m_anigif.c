@@ -18,6 +18,8 @@
 #include "z_zone.h"
 #include "v_video.h"
 #include "i_video.h"
+#include "i_system.h"
+#include "i_threads.h"
 
 #ifdef HWRENDER
 #include "hardware/hw_main.h"
@@ -36,6 +38,7 @@ static boolean gif_downscale = false; // like changing cvars mid output
 static FILE *gif_out = NULL;
 static INT32 gif_frames = 0;
 static UINT8 gif_writeover = 0;
+static INT32 gif_width, gif_height; // the encoder can't look at vid, it runs on its own thread
 
 
 // OPTIMIZE gif output
@@ -51,13 +54,13 @@ static UINT8 gif_writeover = 0;
 static UINT8 GIF_optimizecmprow(const UINT8 *dst, const UINT8 *src, INT32 row,
 	INT32 *last, INT32 *left, INT32 *right)
 {
-	const UINT8 *dp = dst + (vid.width * row);
-	const UINT8 *sp = src + (vid.width * row);
+	const UINT8 *dp = dst + (gif_width * row);
+	const UINT8 *sp = src + (gif_width * row);
 	const UINT8 *dtmp, *stmp;
 	UINT8 doleft = 1, doright = 1;
 	INT32 i = 0;
 
-	if (!memcmp(sp, dp, vid.width))
+	if (!memcmp(sp, dp, gif_width))
 		return 0; // unchanged.
 
 	*last = row;
@@ -84,14 +87,14 @@ static UINT8 GIF_optimizecmprow(const UINT8 *dst, const UINT8 *src, INT32 row,
 	}
 
 	// right side
-	i = vid.width - 1;
-	if (*right == vid.width - 1) // edge reached
+	i = gif_width - 1;
+	if (*right == gif_width - 1) // edge reached
 		doright = 0;
 	else if (*right >= 0) // right set, non-end-of-width
 	{
 		dtmp = dp + *right + 1;
 		stmp = sp + *right + 1;
-		if (!memcmp(stmp, dtmp, vid.width - (*right + 1)))
+		if (!memcmp(stmp, dtmp, gif_width - (*right + 1)))
 			doright = 0; // right side not changed
 	}
 	while (doright)
@@ -121,7 +124,7 @@ static UINT8 GIF_optimizecmprow(const UINT8 *dst, const UINT8 *src, INT32 row,
 static void GIF_optimizeregion(const UINT8 *dst, const UINT8 *src,
 	INT32 *x, INT32 *y, INT32 *w, INT32 *h)
 {
-	INT32 st = 0, sb = vid.height - 1; // work from both directions
+	INT32 st = 0, sb = gif_height - 1; // work from both directions
 	INT32 firstchg_t = -1, firstchg_b = -1; // store first changed row.
 	INT32 lastchg_t = -1, lastchg_b = -1; // Store last row... just in case
 	INT32 lmpix = -1, rmpix = -1; // store left and rightmost change
@@ -132,7 +135,7 @@ static void GIF_optimizeregion(const UINT8 *dst, const UINT8 *src,
 		if (!stopt)
 		{
 			if (GIF_optimizecmprow(dst, src, st++, &lastchg_t, &lmpix, &rmpix)
-			 && lmpix == 0 && rmpix == vid.width - 1)
+			 && lmpix == 0 && rmpix == gif_width - 1)
 				stopt = 1;
 			if (firstchg_t < 0 && lastchg_t >= 0)
 				firstchg_t = lastchg_t;
@@ -140,7 +143,7 @@ static void GIF_optimizeregion(const UINT8 *dst, const UINT8 *src,
 		if (!stopb)
 		{
 			if (GIF_optimizecmprow(dst, src, sb--, &lastchg_b, &lmpix, &rmpix)
-			 && lmpix == 0 && rmpix == vid.width - 1)
+			 && lmpix == 0 && rmpix == gif_width - 1)
 				stopb = 1;
 			if (firstchg_b < 0 && lastchg_b >= 0)
 				firstchg_b = lastchg_b;
@@ -229,9 +232,21 @@ static INT16 scrbuf_downscaleamt = 1;
 #define GIFLZW_DICTSTART 0x102
 #define GIFLZW_MAXCODE 4096
 
+// Twice as many slots as codes, so probes stay short.
+#define GIFLZW_HASHBITS 13
+#define GIFLZW_HASHSIZE (1 << GIFLZW_HASHBITS)
+
 static UINT16 giflzw_workingCode;
 static UINT16 giflzw_nextCodeToAssign;
-static UINT32 *giflzw_hashTable = NULL; // 16384 required
+
+// Keys are 20 bits (code << 8 | byte). The top 12 bits of a slot hold the
+// generation it was written in, so clearing the table is just starting a
+// new generation instead of wiping it.
+static UINT32 *giflzw_hashKeys = NULL;
+static UINT16 *giflzw_hashCodes = NULL;
+static UINT32 giflzw_generation = 0;
+
+#define GIFLZW_HASH(key) (((key) * 2654435761U) >> (32 - GIFLZW_HASHBITS))
 
 //
 // GIF_prepareLZW
@@ -242,9 +257,11 @@ static void GIF_prepareLZW(void)
 	gifbwr_bits_min = 9;
 	giflzw_nextCodeToAssign = GIFLZW_DICTSTART;
 
-	if (!giflzw_hashTable)
-		giflzw_hashTable = Z_Malloc(16384*sizeof(UINT32), PU_STATIC, NULL);
-	memset(giflzw_hashTable, 0, 16384*sizeof(UINT32));
+	if (++giflzw_generation >= (1 << 12))
+	{
+		memset(giflzw_hashKeys, 0, GIFLZW_HASHSIZE*sizeof(UINT32));
+		giflzw_generation = 1;
+	}
 }
 
 //
@@ -253,18 +270,18 @@ static void GIF_prepareLZW(void)
 //
 static char GIF_searchHash(UINT32 key, UINT32 *pOutput)
 {
-	UINT32 entry, position = (key >> 6) & 0x3FFF;
+	const UINT32 tagged = (giflzw_generation << 20) | key;
+	UINT32 entry, position = GIFLZW_HASH(key);
 
-	while (giflzw_hashTable[position] != 0)
+	while (((entry = giflzw_hashKeys[position]) >> 20) == giflzw_generation)
 	{
-		entry = giflzw_hashTable[position];
-		if ((entry >> 12) == key)
+		if (entry == tagged)
 		{
-			*pOutput = (entry & 0xFFF);
+			*pOutput = giflzw_hashCodes[position];
 			return 1;
 		}
 
-		position = (position + 1) & 0x3FFF;
+		position = (position + 1) & (GIFLZW_HASHSIZE - 1);
 	}
 
 	return 0;
@@ -276,18 +293,13 @@ static char GIF_searchHash(UINT32 key, UINT32 *pOutput)
 //
 static void GIF_addHash(UINT32 key, UINT32 value)
 {
-	UINT32 position = (key >> 6) & 0x3FFF;
+	UINT32 position = GIFLZW_HASH(key);
 
-	for (;;)
-	{
-		if (giflzw_hashTable[position] == 0)
-		{
-			giflzw_hashTable[position] = (key << 12) | (value & 0xFFF);
-			return;
-		}
+	while ((giflzw_hashKeys[position] >> 20) == giflzw_generation)
+		position = (position + 1) & (GIFLZW_HASHSIZE - 1);
 
-		position = (position + 1) & 0x3FFF;
-	}
+	giflzw_hashKeys[position] = (giflzw_generation << 20) | key;
+	giflzw_hashCodes[position] = (UINT16)value;
 }
 
 //
@@ -349,8 +361,8 @@ static void GIF_lzw(void)
 		}
 		if ((scrbuf_pos += scrbuf_downscaleamt) >= scrbuf_lineend)
 		{
-			scrbuf_lineend += (vid.width * scrbuf_downscaleamt);
-			scrbuf_linebegin += (vid.width * scrbuf_downscaleamt);
+			scrbuf_lineend += (gif_width * scrbuf_downscaleamt);
+			scrbuf_linebegin += (gif_width * scrbuf_downscaleamt);
 			scrbuf_pos = scrbuf_linebegin;
 		}
 		// Just a bit of overflow prevention
@@ -455,6 +467,9 @@ const UINT8 gifframe_gchead[4] = {0x21,0xF9,0x04,0x04}; // GCE, bytes, packed by
 static UINT8 *gifframe_data = NULL;
 static size_t gifframe_size = 8192;
 
+static UINT8 *gif_convertframe = NULL; // OpenGL frames, turned into palette indexes
+static UINT8 *gif_prevframe = NULL; // last frame written, for GIF_optimizeregion
+
 
 //
 // GIF_rgbconvert
@@ -467,13 +482,11 @@ static void GIF_rgbconvert(UINT8 *linear, UINT8 *scr)
 	size_t src, dest;
 	int x, y;
 
-	InitColorLUT();
-
-	for (x = 0; x < vid.width; x += scrbuf_downscaleamt)
+	for (x = 0; x < gif_width; x += scrbuf_downscaleamt)
 	{
-		for (y = 0; y < vid.height; y += scrbuf_downscaleamt)
+		for (y = 0; y < gif_height; y += scrbuf_downscaleamt)
 		{
-			dest = y*vid.width + x;
+			dest = y*gif_width + x;
 			src = dest*3;
 
 			r = (UINT8)linear[src];
@@ -489,60 +502,32 @@ static void GIF_rgbconvert(UINT8 *linear, UINT8 *scr)
 // GIF_framewrite
 // writes a frame into the file.
 //
-static void GIF_framewrite(void)
+static void GIF_framewrite(UINT8 *frame, boolean rgb)
 {
 	UINT8 *p;
-	UINT8 *movie_screen = screens[2];
+	UINT8 *movie_screen = frame;
 	INT32 blitx, blity, blitw, blith;
 
-	if (!gifframe_data)
-		gifframe_data = Z_Malloc(gifframe_size, PU_STATIC, NULL);
 	p = gifframe_data;
 
-	if (!gif_out)
-		return;
+#ifdef HWRENDER
+	if (rgb)
+	{
+		GIF_rgbconvert(frame, gif_convertframe);
+		movie_screen = gif_convertframe;
+	}
+#else
+	(void)rgb;
+#endif
 
 	// Compare image data (for optimizing GIF)
 	if (gif_optimize && gif_frames > 0)
-	{
-		// before blit movie_screen points to last frame, cur_screen points to this frame
-		UINT8 *cur_screen = screens[0];
-		GIF_optimizeregion(cur_screen, movie_screen, &blitx, &blity, &blitw, &blith);
-
-		// blit to temp screen
-		if (rendermode == render_soft)
-			I_ReadScreen(movie_screen);
-#ifdef HWRENDER
-		else if (rendermode == render_opengl)
-		{
-			UINT8 *linear = HWR_GetScreenshot();
-			GIF_rgbconvert(linear, movie_screen);
-			//free(linear); // Allocated 'statically', no need to free now
-		}
-#endif
-	}
+		GIF_optimizeregion(movie_screen, gif_prevframe, &blitx, &blity, &blitw, &blith);
 	else
 	{
 		blitx = blity = 0;
-		blitw = vid.width;
-		blith = vid.height;
-
-#ifdef HWRENDER
-		// Copy the current OpenGL frame into the base screen
-		if (rendermode == render_opengl)
-		{
-			UINT8 *linear = HWR_GetScreenshot();
-			GIF_rgbconvert(linear, screens[0]);
-			//free(linear); // Allocated 'statically', no need to free now
-		}
-#endif
-
-		// Copy the first frame into the movie screen
-		// OpenGL already does the same above.
-		if (gif_frames == 0 && rendermode == render_soft)
-			I_ReadScreen(movie_screen);
-
-		movie_screen = screens[0];
+		blitw = gif_width;
+		blith = gif_height;
 	}
 
 	// screen regions are handled in GIF_lzw
@@ -574,19 +559,17 @@ static void GIF_framewrite(void)
 		WRITEUINT16(p, (UINT16)(blith / scrbuf_downscaleamt));
 		WRITEUINT8(p, 0); // no local table of colors
 
-		scrbuf_pos = movie_screen + blitx + (blity * vid.width);
-		scrbuf_writeend = scrbuf_pos + (blitw - 1) + ((blith - 1) * vid.width);
+		scrbuf_pos = movie_screen + blitx + (blity * gif_width);
+		scrbuf_writeend = scrbuf_pos + (blitw - 1) + ((blith - 1) * gif_width);
 
-		if (!gifbwr_buf)
-			gifbwr_buf = Z_Malloc(256, PU_STATIC, NULL);
 		gifbwr_cur = gifbwr_buf;
 
 		GIF_prepareLZW();
 		giflzw_workingCode = UINT16_MAX;
 		WRITEUINT8(p, gifbwr_bits_min - 1);
 
-		startline = (scrbuf_pos - movie_screen) / vid.width;
-		scrbuf_linebegin = movie_screen + (startline * vid.width) + blitx;
+		startline = (scrbuf_pos - movie_screen) / gif_width;
+		scrbuf_linebegin = movie_screen + (startline * gif_width) + blitx;
 		scrbuf_lineend = scrbuf_linebegin + blitw;
 
 		//prewrite a table clear
@@ -600,7 +583,9 @@ static void GIF_framewrite(void)
 			if ((size_t)(p - gifframe_data) + gifbwr_bufsize + 1 >= gifframe_size)
 			{
 				INT32 temppos = p - gifframe_data;
-				gifframe_data = Z_Realloc(gifframe_data, (gifframe_size *= 2), PU_STATIC, NULL);
+				gifframe_data = realloc(gifframe_data, (gifframe_size *= 2));
+				if (!gifframe_data)
+					I_Error("GIF_framewrite: out of memory");
 				p = gifframe_data + temppos; // realloc moves gifframe_data, so p is now invalid
 			}
 
@@ -615,11 +600,126 @@ static void GIF_framewrite(void)
 		WRITEUINT8(p, 0); //terminator
 	}
 	fwrite(gifframe_data, 1, (p - gifframe_data), gif_out);
+
+	if (gif_optimize)
+		M_Memcpy(gif_prevframe, movie_screen, gif_width * gif_height);
+
 	++gif_frames;
 }
 
 
 
+// GIF frame QUEUE
+// ---
+// GIF_frame only copies the screen into the next free slot of a small ring
+// of frames. An encoder thread takes them from there and does the region
+// compare, LZW packing and writing, so recording doesn't hold up the game.
+// If the encoder falls GIFQUEUEDEPTH frames behind, GIF_frame waits for a
+// slot, and the waits are counted for GIF_close to report.
+//
+#ifdef HAVE_THREADS
+#define GIFQUEUEDEPTH 8
+#else
+#define GIFQUEUEDEPTH 1
+#endif
+
+static UINT8 *gifqueue[GIFQUEUEDEPTH];
+static boolean gifqueue_rgb; // frames are 24-bit OpenGL screenshots
+static UINT32 gifqueue_head; // frames queued
+static UINT32 gifqueue_tail; // frames written
+
+static INT32 gif_stalls; // frames that had to wait for a free slot
+static precise_t gif_stalltime;
+
+#ifdef HAVE_THREADS
+static I_mutex gifqueue_mutex;
+static I_cond gifqueue_cond; // the encoder waits here for frames
+static I_cond gifqueue_donecond; // and GIF_frame/GIF_close wait here for the encoder
+static boolean gifqueue_closing;
+static boolean gifqueue_running;
+
+static void GIF_encoderthread(void *userdata)
+{
+	(void)userdata;
+
+	I_lock_mutex(&gifqueue_mutex);
+	for (;;)
+	{
+		while (gifqueue_tail == gifqueue_head && !gifqueue_closing)
+			I_hold_cond(&gifqueue_cond, gifqueue_mutex);
+
+		if (gifqueue_tail == gifqueue_head)
+			break; // closing, and everything is written
+
+		I_unlock_mutex(gifqueue_mutex);
+		GIF_framewrite(gifqueue[gifqueue_tail % GIFQUEUEDEPTH], gifqueue_rgb);
+		I_lock_mutex(&gifqueue_mutex);
+
+		gifqueue_tail++;
+		I_wake_all_cond(&gifqueue_donecond);
+	}
+
+	gifqueue_running = false;
+	I_wake_all_cond(&gifqueue_donecond);
+	I_unlock_mutex(gifqueue_mutex);
+}
+#endif
+
+//
+// GIF_allocbuffers
+// the encoder's buffers, malloc'd since the zone isn't safe to use from its thread
+//
+static void GIF_allocbuffers(void)
+{
+	const size_t framesize = gif_width * gif_height * (gifqueue_rgb ? 3 : 1);
+	INT32 i;
+
+	for (i = 0; i < GIFQUEUEDEPTH; i++)
+		gifqueue[i] = malloc(framesize);
+
+	gifframe_size = 8192;
+	gifframe_data = malloc(gifframe_size);
+	gifbwr_buf = malloc(256);
+	giflzw_hashKeys = calloc(GIFLZW_HASHSIZE, sizeof(UINT32));
+	giflzw_hashCodes = malloc(GIFLZW_HASHSIZE * sizeof(UINT16));
+	giflzw_generation = 0;
+	gif_prevframe = malloc(gif_width * gif_height);
+	gif_convertframe = gifqueue_rgb ? calloc(gif_width, gif_height) : NULL;
+
+	if (!gifframe_data || !gifbwr_buf || !giflzw_hashKeys || !giflzw_hashCodes
+		|| !gif_prevframe || (gifqueue_rgb && !gif_convertframe))
+		I_Error("GIF_open: out of memory");
+	for (i = 0; i < GIFQUEUEDEPTH; i++)
+		if (!gifqueue[i])
+			I_Error("GIF_open: out of memory");
+}
+
+static void GIF_freebuffers(void)
+{
+	INT32 i;
+
+	for (i = 0; i < GIFQUEUEDEPTH; i++)
+	{
+		free(gifqueue[i]);
+		gifqueue[i] = NULL;
+	}
+
+	free(gifframe_data);
+	gifframe_data = NULL;
+	free(gifbwr_buf);
+	gifbwr_buf = gifbwr_cur = NULL;
+	free(giflzw_hashKeys);
+	giflzw_hashKeys = NULL;
+	free(giflzw_hashCodes);
+	giflzw_hashCodes = NULL;
+	free(gif_prevframe);
+	gif_prevframe = NULL;
+	free(gif_convertframe);
+	gif_convertframe = NULL;
+}
+
+
+
 // ========================
 // !!! PUBLIC FUNCTIONS !!!
 // ========================
@@ -636,8 +736,22 @@ INT32 GIF_open(const char *filename)
 
 	gif_optimize = (!!cv_gif_optimize.value);
 	gif_downscale = (!!cv_gif_downscale.value);
+	gif_width = vid.width;
+	gif_height = vid.height;
 	GIF_headwrite();
 	gif_frames = 0;
+
+	gifqueue_rgb = (rendermode != render_soft);
+	gifqueue_head = gifqueue_tail = 0;
+	gif_stalls = 0;
+	gif_stalltime = 0;
+	GIF_allocbuffers();
+
+#ifdef HAVE_THREADS
+	gifqueue_closing = false;
+	gifqueue_running = true;
+	I_spawn_thread("gif-encoder", GIF_encoderthread, NULL);
+#endif
 	return 1;
 }
 
@@ -647,8 +761,55 @@ INT32 GIF_open(const char *filename)
 //
 void GIF_frame(void)
 {
-	// there's not much actually needed here, is there.
-	GIF_framewrite();
+	UINT8 *slot;
+
+	if (!gif_out)
+		return;
+
+	// The file can't change size halfway through.
+	if (vid.width != gif_width || vid.height != gif_height)
+		return;
+
+#ifdef HAVE_THREADS
+	I_lock_mutex(&gifqueue_mutex);
+	if (gifqueue_head - gifqueue_tail >= GIFQUEUEDEPTH)
+	{
+		const precise_t start = I_GetPreciseTime();
+
+		while (gifqueue_head - gifqueue_tail >= GIFQUEUEDEPTH)
+			I_hold_cond(&gifqueue_donecond, gifqueue_mutex);
+
+		gif_stalls++;
+		gif_stalltime += I_GetPreciseTime() - start;
+	}
+	I_unlock_mutex(gifqueue_mutex);
+#endif
+
+	slot = gifqueue[gifqueue_head % GIFQUEUEDEPTH];
+
+	if (rendermode == render_soft)
+		I_ReadScreen(slot);
+#ifdef HWRENDER
+	else if (rendermode == render_opengl)
+	{
+		UINT8 *linear = HWR_GetScreenshot();
+		if (!linear)
+			return;
+		InitColorLUT(); // here, so the encoder only ever reads it
+		M_Memcpy(slot, linear, gif_width * gif_height * 3);
+	}
+#endif
+
+#ifdef HAVE_THREADS
+	I_lock_mutex(&gifqueue_mutex);
+	gifqueue_head++;
+	I_wake_all_cond(&gifqueue_cond);
+	I_unlock_mutex(gifqueue_mutex);
+#else
+	GIF_framewrite(slot, gifqueue_rgb);
+	gifqueue_head++;
+	gifqueue_tail++;
+#endif
 }
 
 //
@@ -660,24 +821,27 @@ INT32 GIF_close(void)
 	if (!gif_out)
 		return 0;
 
+#ifdef HAVE_THREADS
+	// let the encoder catch up and finish
+	I_lock_mutex(&gifqueue_mutex);
+	gifqueue_closing = true;
+	I_wake_all_cond(&gifqueue_cond);
+	while (gifqueue_running)
+		I_hold_cond(&gifqueue_donecond, gifqueue_mutex);
+	I_unlock_mutex(gifqueue_mutex);
+#endif
+
 	// final terminator.
 	fwrite(";", 1, 1, gif_out);
 	fclose(gif_out);
 	gif_out = NULL;
 
-	if (gifbwr_buf)
-		Z_Free(gifbwr_buf);
-	gifbwr_buf = gifbwr_cur = NULL;
-
-	if (gifframe_data)
-		Z_Free(gifframe_data);
-	gifframe_data = NULL;
-
-	if (giflzw_hashTable)
-		Z_Free(giflzw_hashTable);
-	giflzw_hashTable = NULL;
+	GIF_freebuffers();
 
 	CONS_Printf(M_GetText("Animated gif closed; wrote %d frames\n"), gif_frames);
+	if (gif_stalls)
+		CONS_Printf(M_GetText("%d frames waited %d ms for the encoder\n"), gif_stalls,
+			(INT32)(gif_stalltime * 1000 / I_GetPrecisePrecision()));
 	return 1;
 }
 #endif //ifdef HAVE_ANIGIF
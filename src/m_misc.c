@@ -43,6 +43,8 @@
 #include "command.h" // cv_execversion
 
 #include "m_anigif.h"
+#include "m_rawvideo.h"
+#include "i_threads.h"
 
 // So that the screenshot menu auto-updates...
 #include "m_menu.h"
@@ -105,7 +107,7 @@ static CV_PossibleValue_t screenshot_cons_t[] = {{0, "Default"}, {1, "HOME"}, {2
 consvar_t cv_screenshot_option = {"screenshot_option", "Default", CV_SAVE|CV_CALL, screenshot_cons_t, Screenshot_option_Onchange, 0, NULL, NULL, 0, 0, NULL};
 consvar_t cv_screenshot_folder = {"screenshot_folder", "", CV_SAVE, NULL, NULL, 0, NULL, NULL, 0, 0, NULL};
 
-static CV_PossibleValue_t moviemode_cons_t[] = {{MM_GIF, "GIF"}, {MM_APNG, "aPNG"}, {MM_SCREENSHOT, "Screenshots"}, {0, NULL}};
+static CV_PossibleValue_t moviemode_cons_t[] = {{MM_GIF, "GIF"}, {MM_APNG, "aPNG"}, {MM_SCREENSHOT, "Screenshots"}, {MM_Y4M, "Y4M"}, {0, NULL}};
 consvar_t cv_moviemode = {"moviemode_mode", "GIF", CV_SAVE|CV_CALL, moviemode_cons_t, Moviemode_mode_Onchange, 0, NULL, NULL, 0, 0, NULL};
 
 static CV_PossibleValue_t zlib_mem_level_t[] = {
@@ -750,70 +752,81 @@ static void M_PNGhdr(png_structp png_ptr, png_infop png_info_ptr, PNG_CONST png_
 	}
 }
 
-static void M_PNGText(png_structp png_ptr, png_infop png_info_ptr, PNG_CONST png_byte movie)
+// The parts of the PNG text that come from the game, taken when the picture
+// is, since the PNG may be written on another thread.
+typedef struct
 {
-#ifdef PNG_TEXT_SUPPORTED
-#define SRB2PNGTXT 11 //PNG_KEYWORD_MAX_LENGTH(79) is the max
-	png_text png_infotext[SRB2PNGTXT];
-	char keytxt[SRB2PNGTXT][12] = {
-	"Title", "Description", "Playername", "Mapnum", "Mapname",
-	"Location", "Interface", "Render Mode", "Revision", "Build Date", "Build Time"};
-	char titletxt[] = "SRB2Kart " VERSIONSTRING;
-	png_charp playertxt =  cv_playername.zstring;
-	char desctxt[] = "SRB2Kart Screenshot";
-	char Movietxt[] = "SRB2Kart Movie";
-	size_t i;
-	char interfacetxt[] =
-#ifdef HAVE_SDL
-	 "SDL";
-#elif defined (_WINDOWS)
-	 "DirectX";
-#else
-	 "Unknown";
-#endif
+	char playertxt[MAXPLAYERNAME+1];
 	char rendermodetxt[9];
 	char maptext[8];
 	char lvlttltext[48];
 	char locationtxt[40];
-	char ctrevision[40];
-	char ctdate[40];
-	char cttime[40];
+} pngtextinfo_t;
+
+static void M_PNGGetTextInfo(pngtextinfo_t *info)
+{
+	strlcpy(info->playertxt, cv_playername.zstring, sizeof info->playertxt);
 
 	switch (rendermode)
 	{
 		case render_soft:
-			strcpy(rendermodetxt, "Software");
+			strcpy(info->rendermodetxt, "Software");
 			break;
 		case render_opengl:
-			strcpy(rendermodetxt, "OpenGL");
+			strcpy(info->rendermodetxt, "OpenGL");
 			break;
 		default: // Just in case
-			strcpy(rendermodetxt, "None");
+			strcpy(info->rendermodetxt, "None");
 			break;
 	}
 
 	if (gamestate == GS_LEVEL)
-		snprintf(maptext, 8, "%s", G_BuildMapName(gamemap));
+		snprintf(info->maptext, 8, "%s", G_BuildMapName(gamemap));
 	else
-		snprintf(maptext, 8, "Unknown");
+		snprintf(info->maptext, 8, "Unknown");
 
 	if (gamestate == GS_LEVEL && mapheaderinfo[gamemap-1]->lvlttl[0] != '\0')
-		snprintf(lvlttltext, 48, "%s%s%s",
+		snprintf(info->lvlttltext, 48, "%s%s%s",
 			mapheaderinfo[gamemap-1]->lvlttl,
 			(strlen(mapheaderinfo[gamemap-1]->zonttl) > 0) ? va(" %s",mapheaderinfo[gamemap-1]->zonttl) : // SRB2kart
 			((mapheaderinfo[gamemap-1]->levelflags & LF_NOZONE) ? "" : " ZONE"),
 			(strlen(mapheaderinfo[gamemap-1]->actnum) > 0) ? va(" %s",mapheaderinfo[gamemap-1]->actnum) : "");
 	else
-		snprintf(lvlttltext, 48, "Unknown");
+		snprintf(info->lvlttltext, 48, "Unknown");
 
 	if (gamestate == GS_LEVEL && players[displayplayers[0]].mo)
-		snprintf(locationtxt, 40, "X:%d Y:%d Z:%d A:%d",
+		snprintf(info->locationtxt, 40, "X:%d Y:%d Z:%d A:%d",
 			players[displayplayers[0]].mo->x>>FRACBITS,
 			players[displayplayers[0]].mo->y>>FRACBITS,
 			players[displayplayers[0]].mo->z>>FRACBITS,
 			FixedInt(AngleFixed(players[displayplayers[0]].mo->angle)));
 	else
-		snprintf(locationtxt, 40, "Unknown");
+		snprintf(info->locationtxt, 40, "Unknown");
+}
+
+static void M_PNGText(png_structp png_ptr, png_infop png_info_ptr, PNG_CONST png_byte movie, pngtextinfo_t *info)
+{
+#ifdef PNG_TEXT_SUPPORTED
+#define SRB2PNGTXT 11 //PNG_KEYWORD_MAX_LENGTH(79) is the max
+	png_text png_infotext[SRB2PNGTXT];
+	char keytxt[SRB2PNGTXT][12] = {
+	"Title", "Description", "Playername", "Mapnum", "Mapname",
+	"Location", "Interface", "Render Mode", "Revision", "Build Date", "Build Time"};
+	char titletxt[] = "SRB2Kart " VERSIONSTRING;
+	char desctxt[] = "SRB2Kart Screenshot";
+	char Movietxt[] = "SRB2Kart Movie";
+	size_t i;
+	char interfacetxt[] =
+#ifdef HAVE_SDL
+	 "SDL";
+#elif defined (_WINDOWS)
+	 "DirectX";
+#else
+	 "Unknown";
+#endif
+	char ctrevision[40];
+	char ctdate[40];
+	char cttime[40];
 
 	memset(png_infotext,0x00,sizeof (png_infotext));
 
@@ -825,18 +838,23 @@ static void M_PNGText(png_structp png_ptr, png_infop png_info_ptr, PNG_CONST png
 		png_infotext[1].text = Movietxt;
 	else
 		png_infotext[1].text = desctxt;
-	png_infotext[2].text = playertxt;
-	png_infotext[3].text = maptext;
-	png_infotext[4].text = lvlttltext;
-	png_infotext[5].text = locationtxt;
+	png_infotext[2].text = info->playertxt;
+	png_infotext[3].text = info->maptext;
+	png_infotext[4].text = info->lvlttltext;
+	png_infotext[5].text = info->locationtxt;
 	png_infotext[6].text = interfacetxt;
-	png_infotext[7].text = rendermodetxt;
+	png_infotext[7].text = info->rendermodetxt;
 	png_infotext[8].text = strncpy(ctrevision, comprevision, sizeof(ctrevision)-1);
 	png_infotext[9].text = strncpy(ctdate, compdate, sizeof(ctdate)-1);
 	png_infotext[10].text = strncpy(cttime, comptime, sizeof(cttime)-1);
 
 	png_set_text(png_ptr, png_info_ptr, png_infotext, SRB2PNGTXT);
 #undef SRB2PNGTXT
+#else
+	(void)png_ptr;
+	(void)png_info_ptr;
+	(void)movie;
+	(void)info;
 #endif
 }
 
@@ -859,7 +877,8 @@ static png_structp apng_ptr = NULL;
 static png_infop   apng_info_ptr = NULL;
 static apng_infop  apng_ainfo_ptr = NULL;
 static png_FILE_p  apng_FILE = NULL;
-static png_uint_32 apng_frames = 0;
+static png_uint_32 apng_frames = 0; // written, by the PNG writer
+static UINT32 apng_queuedframes = 0; // handed to it
 #ifdef PNG_STATIC // Win32 build have static libpng
 #define aPNG_set_acTL png_set_acTL
 #define aPNG_write_frame_head png_write_frame_head
@@ -955,13 +974,12 @@ static inline boolean M_PNGLib(void)
 #endif
 }
 
-static void M_PNGFrame(png_structp png_ptr, png_infop png_info_ptr, png_bytep png_buf)
+static void M_PNGFrame(png_structp png_ptr, png_infop png_info_ptr, png_bytep png_buf,
+	PNG_CONST png_uint_32 width, PNG_CONST png_uint_32 height, png_uint_16 framedelay)
 {
 	png_uint_32 pitch = png_get_rowbytes(png_ptr, png_info_ptr);
-	PNG_CONST png_uint_32 height = vid.height;
 	png_bytepp row_pointers = png_malloc(png_ptr, height* sizeof (png_bytep));
 	png_uint_32 y;
-	png_uint_16 framedelay = (png_uint_16)cv_apng_delay.value;
 
 	apng_frames++;
 
@@ -975,7 +993,7 @@ static void M_PNGFrame(png_structp png_ptr, png_infop png_info_ptr, png_bytep pn
 	if (aPNG_write_frame_head)
 #endif
 		aPNG_write_frame_head(apng_ptr, apng_info_ptr, row_pointers,
-			vid.width, /* width */
+			width,     /* width */
 			height,    /* height */
 			0,         /* x offset */
 			0,         /* y offset */
@@ -1006,6 +1024,8 @@ static void M_PNGfix_acTL(png_structp png_ptr, png_infop png_info_ptr,
 
 static boolean M_SetupaPNG(png_const_charp filename, png_bytep pal)
 {
+	pngtextinfo_t textinfo;
+
 	apng_FILE = fopen(filename,"wb+"); // + mode for reading
 	if (!apng_FILE)
 	{
@@ -1058,7 +1078,8 @@ static boolean M_SetupaPNG(png_const_charp filename, png_bytep pal)
 
 	M_PNGhdr(apng_ptr, apng_info_ptr, vid.width, vid.height, pal);
 
-	M_PNGText(apng_ptr, apng_info_ptr, true);
+	M_PNGGetTextInfo(&textinfo);
+	M_PNGText(apng_ptr, apng_info_ptr, true, &textinfo);
 
 	apng_set_set_acTL_fn(apng_ptr, apng_ainfo_ptr, aPNG_set_acTL);
 
@@ -1067,12 +1088,250 @@ static boolean M_SetupaPNG(png_const_charp filename, png_bytep pal)
 	apng_write_info(apng_ptr, apng_info_ptr, apng_ainfo_ptr);
 
 	apng_frames = 0;
+	apng_queuedframes = 0;
 
 	return true;
 }
 #endif
 #endif
 
+// ==========================================================================
+//                           PNG WRITER THREAD
+// ==========================================================================
+// Screenshots and aPNG frames are copied into a job and handed to a writer
+// thread, which does the filtering, deflating and file writing while the
+// game carries on. Jobs are written one after another, in the order they
+// were taken, so aPNG frames stay in sequence. The game only waits when
+// PNGQUEUEDEPTH jobs are already pending.
+#ifdef USE_PNG
+#ifdef HAVE_THREADS
+#define PNGQUEUEDEPTH 4
+#else
+#define PNGQUEUEDEPTH 1
+#endif
+
+typedef enum
+{
+	PNGJOB_SCREENSHOT,
+	PNGJOB_APNGFRAME,
+	PNGJOB_APNGEND
+} pngjobtype_t;
+
+typedef struct
+{
+	pngjobtype_t type;
+	UINT8 *data; // 8-bit screen, or 24-bit RGB if not paletted
+	size_t datasize;
+	INT32 width, height;
+	boolean paletted;
+	UINT8 palette[768];
+	pngtextinfo_t textinfo;
+	INT32 zlevel, zmemory, zstrategy, zwindowbits;
+	UINT16 framedelay;
+	boolean quiet; // taken in screenshot movie mode, don't report it
+	char freename[16];
+	char pathname[256];
+} pngjob_t;
+
+static pngjob_t pngqueue[PNGQUEUEDEPTH];
+static UINT32 pngqueue_head; // jobs queued
+static UINT32 pngqueue_tail; // jobs written
+static boolean pngqueue_failed; // a screenshot movie frame couldn't be written
+
+static boolean M_WritePNG(const char *filename, void *data, int width, int height, const UINT8 *palette,
+	pngtextinfo_t *textinfo, INT32 zlevel, INT32 zmemory, INT32 zstrategy, INT32 zwindowbits);
+
+static void M_RunPNGJob(pngjob_t *job)
+{
+	char filename[256+16+2];
+
+	switch (job->type)
+	{
+		case PNGJOB_SCREENSHOT:
+			snprintf(filename, sizeof filename, pandf, job->pathname, job->freename);
+			if (M_WritePNG(filename, job->data, job->width, job->height, job->paletted ? job->palette : NULL,
+				&job->textinfo, job->zlevel, job->zmemory, job->zstrategy, job->zwindowbits))
+			{
+				if (!job->quiet)
+					CONS_Printf(M_GetText("Screen shot %s saved in %s\n"), job->freename, job->pathname);
+			}
+			else
+			{
+				remove(filename); // the empty file that reserved the name
+				CONS_Alert(CONS_ERROR, M_GetText("Couldn't create screen shot %s in %s\n"), job->freename, job->pathname);
+				if (job->quiet)
+					pngqueue_failed = true;
+			}
+			break;
+#ifdef USE_APNG
+		case PNGJOB_APNGFRAME:
+			M_PNGFrame(apng_ptr, apng_info_ptr, (png_bytep)job->data, job->width, job->height, job->framedelay);
+			break;
+		case PNGJOB_APNGEND:
+			if (apng_frames)
+			{
+				M_PNGfix_acTL(apng_ptr, apng_info_ptr, apng_ainfo_ptr);
+				apng_write_end(apng_ptr, apng_info_ptr, apng_ainfo_ptr);
+			}
+
+			png_destroy_write_struct(&apng_ptr, &apng_info_ptr);
+
+			fclose(apng_FILE);
+			apng_FILE = NULL;
+			CONS_Printf("aPNG closed; wrote %u frames\n", (UINT32)apng_frames);
+			apng_frames = 0;
+			break;
+#endif
+		default:
+			break;
+	}
+}
+
+#ifdef HAVE_THREADS
+static I_mutex pngqueue_mutex;
+static I_cond pngqueue_cond; // the writer waits here for jobs
+static I_cond pngqueue_donecond; // and the game waits here for the writer
+static boolean pngqueue_spawned;
+static boolean pngqueue_quit;
+static boolean pngqueue_running;
+
+static void M_PNGWriterThread(void *userdata)
+{
+	(void)userdata;
+
+	I_lock_mutex(&pngqueue_mutex);
+	for (;;)
+	{
+		while (pngqueue_tail == pngqueue_head && !pngqueue_quit)
+			I_hold_cond(&pngqueue_cond, pngqueue_mutex);
+
+		if (pngqueue_tail == pngqueue_head)
+			break; // quitting, and everything is written
+
+		I_unlock_mutex(pngqueue_mutex);
+		M_RunPNGJob(&pngqueue[pngqueue_tail % PNGQUEUEDEPTH]);
+		I_lock_mutex(&pngqueue_mutex);
+
+		pngqueue_tail++;
+		I_wake_all_cond(&pngqueue_donecond);
+	}
+
+	pngqueue_running = false;
+	I_wake_all_cond(&pngqueue_donecond);
+	I_unlock_mutex(pngqueue_mutex);
+}
+
+// Writes out everything still queued before the game quits.
+static void M_StopPNGWriter(void)
+{
+	I_lock_mutex(&pngqueue_mutex);
+	pngqueue_quit = true;
+	I_wake_all_cond(&pngqueue_cond);
+	while (pngqueue_running)
+		I_hold_cond(&pngqueue_donecond, pngqueue_mutex);
+	I_unlock_mutex(pngqueue_mutex);
+}
+#endif
+
+#ifdef USE_APNG
+//
+// M_FlushPNGQueue
+// waits for every queued job to be written
+//
+static void M_FlushPNGQueue(void)
+{
+#ifdef HAVE_THREADS
+	I_lock_mutex(&pngqueue_mutex);
+	while (pngqueue_tail != pngqueue_head && pngqueue_running)
+		I_hold_cond(&pngqueue_donecond, pngqueue_mutex);
+	I_unlock_mutex(pngqueue_mutex);
+#endif
+}
+#endif
+
+//
+// M_GetPNGJob
+// returns the next free job, with room for a width x height picture
+//
+static pngjob_t *M_GetPNGJob(pngjobtype_t type, INT32 width, INT32 height, boolean paletted)
+{
+	const size_t datasize = width * height * (paletted ? 1 : 3);
+	pngjob_t *job;
+
+#ifdef HAVE_THREADS
+	if (!pngqueue_spawned)
+	{
+		pngqueue_spawned = pngqueue_running = true;
+		I_AddExitFunc(M_StopPNGWriter);
+		I_spawn_thread("png-writer", M_PNGWriterThread, NULL);
+	}
+
+	I_lock_mutex(&pngqueue_mutex);
+	while (pngqueue_head - pngqueue_tail >= PNGQUEUEDEPTH)
+		I_hold_cond(&pngqueue_donecond, pngqueue_mutex);
+	I_unlock_mutex(pngqueue_mutex);
+#endif
+
+	job = &pngqueue[pngqueue_head % PNGQUEUEDEPTH];
+	job->type = type;
+	job->width = width;
+	job->height = height;
+	job->paletted = paletted;
+
+	if (job->datasize < datasize)
+	{
+		job->data = realloc(job->data, datasize);
+		if (!job->data)
+			I_Error("M_GetPNGJob: out of memory");
+		job->datasize = datasize;
+	}
+
+	return job;
+}
+
+//
+// M_QueuePNGJob
+// hands the job from M_GetPNGJob to the writer
+//
+static void M_QueuePNGJob(void)
+{
+#ifdef HAVE_THREADS
+	I_lock_mutex(&pngqueue_mutex);
+	pngqueue_head++;
+	I_wake_all_cond(&pngqueue_cond);
+	I_unlock_mutex(pngqueue_mutex);
+#else
+	M_RunPNGJob(&pngqueue[pngqueue_head % PNGQUEUEDEPTH]);
+	pngqueue_head++;
+	pngqueue_tail++;
+#endif
+}
+
+//
+// M_ReadScreenForPNG
+// copies the current screen into a job
+//
+static boolean M_ReadScreenForPNG(pngjob_t *job)
+{
+	if (rendermode == render_soft)
+	{
+		I_ReadScreen(job->data);
+		return true;
+	}
+#ifdef HWRENDER
+	else if (rendermode == render_opengl)
+	{
+		UINT8 *linear = HWR_GetScreenshot();
+		if (!linear)
+			return false;
+		M_Memcpy(job->data, linear, job->width * job->height * 3);
+		return true;
+	}
+#endif
+	return false;
+}
+#endif
+
 // ==========================================================================
 //                             MOVIE MODE
 // ==========================================================================
@@ -1096,6 +1355,9 @@ static inline moviemode_t M_StartMovieAPNG(const char *pathname)
 		return MM_OFF;
 	}
 
+	// the last aPNG might still be getting finished
+	M_FlushPNGQueue();
+
 	if (rendermode == render_soft) M_CreateScreenShotPalette();
 	ret = M_SetupaPNG(va(pandf,pathname,freename), (palette = screenshot_palette));
 
@@ -1137,6 +1399,38 @@ static inline moviemode_t M_StartMovieGIF(const char *pathname)
 	return MM_OFF;
 #endif
 }
+
+static moviemode_t M_StartMovieY4M(const char *pathname)
+{
+	char videoname[MAX_WADPATH], audioname[MAX_WADPATH];
+	const char *freename;
+
+	if (*cv_y4m_path.string != '\0')
+		strlcpy(videoname, cv_y4m_path.string, sizeof videoname);
+	else if ((freename = Newsnapshotfile(pathname,"y4m")) != NULL)
+		strlcpy(videoname, va(pandf,pathname,freename), sizeof videoname);
+	else
+	{
+		CONS_Alert(CONS_ERROR, "Couldn't create Y4M: no slots open in %s\n", pathname);
+		return MM_OFF;
+	}
+
+	// Pair the audio up with the video by name, unless told otherwise.
+	if (*cv_y4m_audiopath.string != '\0')
+		strlcpy(audioname, cv_y4m_audiopath.string, sizeof audioname);
+	else
+	{
+		strlcpy(audioname, videoname, sizeof audioname);
+		FIL_ForceExtension(audioname, ".pcm");
+	}
+
+	if (!Y4M_open(videoname, audioname))
+	{
+		CONS_Alert(CONS_ERROR, "Couldn't create Y4M: error creating %s\n", videoname);
+		return MM_OFF;
+	}
+	return MM_Y4M;
+}
 #endif
 
 void M_StartMovie(void)
@@ -1170,6 +1464,9 @@ void M_StartMovie(void)
 		case MM_SCREENSHOT:
 			moviemode = MM_SCREENSHOT;
 			break;
+		case MM_Y4M:
+			moviemode = M_StartMovieY4M(pathname);
+			break;
 		default: //???
 			return;
 	}
@@ -1180,6 +1477,8 @@ void M_StartMovie(void)
 		CONS_Printf(M_GetText("Movie mode enabled (%s).\n"), "GIF");
 	else if (moviemode == MM_SCREENSHOT)
 		CONS_Printf(M_GetText("Movie mode enabled (%s).\n"), "screenshots");
+	else if (moviemode == MM_Y4M)
+		CONS_Printf(M_GetText("Movie mode enabled (%s).\n"), "Y4M");
 
 	//singletics = (moviemode != MM_OFF);
 #endif
@@ -1191,6 +1490,14 @@ void M_SaveFrame(void)
 	// paranoia: should be unnecessary without singletics
 	static tic_t oldtic = 0;
 
+	// Y4M keeps its own time, in game tics, so it can't fall behind.
+	if (moviemode == MM_Y4M)
+	{
+		if (!Y4M_frame())
+			M_StopMovie();
+		return;
+	}
+
 	if (oldtic == I_GetTime())
 		return;
 	else
@@ -1199,6 +1506,14 @@ void M_SaveFrame(void)
 	switch (moviemode)
 	{
 		case MM_SCREENSHOT:
+#ifdef USE_PNG
+			if (pngqueue_failed)
+			{
+				pngqueue_failed = false;
+				M_StopMovie();
+				return;
+			}
+#endif
 			takescreenshot = true;
 			return;
 		case MM_GIF:
@@ -1207,30 +1522,20 @@ void M_SaveFrame(void)
 		case MM_APNG:
 #ifdef USE_APNG
 			{
-				UINT8 *linear = NULL;
+				pngjob_t *job;
 				if (!apng_FILE) // should not happen!!
 				{
 					moviemode = MM_OFF;
 					return;
 				}
 
-				if (rendermode == render_soft)
-				{
-					// munge planar buffer to linear
-					linear = screens[2];
-					I_ReadScreen(linear);
-				}
-#ifdef HWRENDER
-				else
-					linear = HWR_GetScreenshot();
-#endif
-				M_PNGFrame(apng_ptr, apng_info_ptr, (png_bytep)linear);
-#ifdef HWRENDER
-				if (rendermode != render_soft && linear)
-					free(linear);
-#endif
+				job = M_GetPNGJob(PNGJOB_APNGFRAME, vid.width, vid.height, rendermode == render_soft);
+				if (!M_ReadScreenForPNG(job))
+					return;
+				job->framedelay = (UINT16)cv_apng_delay.value;
+				M_QueuePNGJob();
 
-				if (apng_frames == PNG_UINT_31_MAX)
+				if (++apng_queuedframes == PNG_UINT_31_MAX)
 				{
 					CONS_Alert(CONS_NOTICE, M_GetText("Max movie size reached\n"));
 					M_StopMovie();
@@ -1260,24 +1565,19 @@ void M_StopMovie(void)
 			if (!apng_FILE)
 				return;
 
-			if (apng_frames)
-			{
-				M_PNGfix_acTL(apng_ptr, apng_info_ptr, apng_ainfo_ptr);
-				apng_write_end(apng_ptr, apng_info_ptr, apng_ainfo_ptr);
-			}
-
-			png_destroy_write_struct(&apng_ptr, &apng_info_ptr);
-
-			fclose(apng_FILE);
-			apng_FILE = NULL;
-			CONS_Printf("aPNG closed; wrote %u frames\n", (UINT32)apng_frames);
-			apng_frames = 0;
+			// the writer closes it after the last frame
+			M_GetPNGJob(PNGJOB_APNGEND, 0, 0, true);
+			M_QueuePNGJob();
 			break;
 #else
 			return;
 #endif
 		case MM_SCREENSHOT:
 			break;
+		case MM_Y4M:
+			if (!Y4M_close())
+				return;
+			break;
 		default:
 			return;
 	}
@@ -1300,6 +1600,18 @@ void M_StopMovie(void)
   *  \note if palette is NULL, BGR888 format
   */
 boolean M_SavePNG(const char *filename, void *data, int width, int height, const UINT8 *palette)
+{
+	pngtextinfo_t textinfo;
+
+	M_PNGGetTextInfo(&textinfo);
+	return M_WritePNG(filename, data, width, height, palette, &textinfo,
+		cv_zlib_level.value, cv_zlib_memory.value, cv_zlib_strategy.value, cv_zlib_window_bits.value);
+}
+
+// M_SavePNG, with everything it would read from the game passed in,
+// so the PNG writer thread can use it.
+static boolean M_WritePNG(const char *filename, void *data, int width, int height, const UINT8 *palette,
+	pngtextinfo_t *textinfo, INT32 zlevel, INT32 zmemory, INT32 zstrategy, INT32 zwindowbits)
 {
 	png_structp png_ptr;
 	png_infop png_info_ptr;
@@ -1360,14 +1672,14 @@ boolean M_SavePNG(const char *filename, void *data, int width, int height, const
 
 	//png_set_filter(png_ptr, 0, PNG_ALL_FILTERS);
 
-	png_set_compression_level(png_ptr, cv_zlib_level.value);
-	png_set_compression_mem_level(png_ptr, cv_zlib_memory.value);
-	png_set_compression_strategy(png_ptr, cv_zlib_strategy.value);
-	png_set_compression_window_bits(png_ptr, cv_zlib_window_bits.value);
+	png_set_compression_level(png_ptr, zlevel);
+	png_set_compression_mem_level(png_ptr, zmemory);
+	png_set_compression_strategy(png_ptr, zstrategy);
+	png_set_compression_window_bits(png_ptr, zwindowbits);
 
 	M_PNGhdr(png_ptr, png_info_ptr, width, height, PLTE);
 
-	M_PNGText(png_ptr, png_info_ptr, false);
+	M_PNGText(png_ptr, png_info_ptr, false, textinfo);
 
 	png_write_info(png_ptr, png_info_ptr);
 
@@ -1502,6 +1814,36 @@ void M_DoScreenShot(void)
 
 #ifdef USE_PNG
 	freename = Newsnapshotfile(pathname,"png");
+
+	// Written on the PNG writer thread, which reports how it went.
+	if (freename)
+	{
+		pngjob_t *job = M_GetPNGJob(PNGJOB_SCREENSHOT, vid.width, vid.height, rendermode == render_soft);
+		FILE *reserved;
+
+		// Newsnapshotfile only skips names on disk, so claim this one now,
+		// before another screenshot gets queued under the same name.
+		if (M_ReadScreenForPNG(job) && (reserved = fopen(va(pandf,pathname,freename), "wb")) != NULL)
+		{
+			fclose(reserved);
+
+			if (job->paletted)
+			{
+				M_CreateScreenShotPalette();
+				M_Memcpy(job->palette, screenshot_palette, sizeof job->palette);
+			}
+			M_PNGGetTextInfo(&job->textinfo);
+			job->zlevel = cv_zlib_level.value;
+			job->zmemory = cv_zlib_memory.value;
+			job->zstrategy = cv_zlib_strategy.value;
+			job->zwindowbits = cv_zlib_window_bits.value;
+			job->quiet = (moviemode == MM_SCREENSHOT);
+			strlcpy(job->freename, freename, sizeof job->freename);
+			strlcpy(job->pathname, pathname, sizeof job->pathname);
+			M_QueuePNGJob();
+			return;
+		}
+	}
 #else
 	if (rendermode == render_soft)
 		freename = Newsnapshotfile(pathname,"pcx");
@@ -25,7 +25,8 @@ typedef enum {
 	MM_OFF = 0,
 	MM_APNG,
 	MM_GIF,
-	MM_SCREENSHOT
+	MM_SCREENSHOT,
+	MM_Y4M
 } moviemode_t;
 extern moviemode_t moviemode;
 
@@ -19,6 +19,7 @@
 #include "z_zone.h"
 #include "p_local.h"
 #include "r_fps.h"
+#include "p_polyobj.h"
 
 #ifdef HWRENDER
 #include "hardware/hw_main.h"
@@ -59,10 +60,10 @@ static ps_metric_t ps_regularcount = {0};
 static ps_metric_t ps_scenerycount = {0};
 static ps_metric_t ps_nothinkcount = {0};
 static ps_metric_t ps_otherthcount = {0};
-static ps_metric_t ps_precipcount = {0};
 static ps_metric_t ps_removecount = {0};
 
 ps_metric_t ps_checkposition_calls = {0};
+ps_metric_t ps_dynslopes_updated = {0};
 
 ps_metric_t ps_lua_prethinkframe_time = {0};
 ps_metric_t ps_lua_thinkframe_time = {0};
@@ -101,15 +102,18 @@ perfstatrow_t rendertime_rows[] = {
 #endif
 
 	{" skybox ", " Skybox render: ", &ps_skyboxtime, PS_TIME|PS_LEVEL|PS_SW},
+	{"  skysav", "  Cache saved: ", &ps_sw_skyboxsaved, PS_TIME|PS_LEVEL|PS_SW},
 	{" bsptime", " RenderBSPNode: ", &ps_bsptime, PS_TIME|PS_LEVEL|PS_SW},
 	{" sprclip", " R_ClipSprites: ", &ps_sw_spritecliptime, PS_TIME|PS_LEVEL|PS_SW},
 	{" portals", " Portals:       ", &ps_sw_portaltime, PS_TIME|PS_LEVEL|PS_SW},
 	{" planes ", " R_DrawPlanes:  ", &ps_sw_planetime, PS_TIME|PS_LEVEL|PS_SW},
 	{" masked ", " R_DrawMasked:  ", &ps_sw_maskedtime, PS_TIME|PS_LEVEL|PS_SW},
+	{"  sprsrt", "  Sprite sort:  ", &ps_sw_spritesorttime, PS_TIME|PS_LEVEL|PS_SW},
 	{" other  ", " Other:         ", &ps_otherrendertime, PS_TIME|PS_LEVEL|PS_SW},
 
 	{"ui     ", "UI render:     ", &ps_uitime, PS_TIME},
 	{"finupdt", "I_FinishUpdate:", &ps_swaptime, PS_TIME},
+	{" present", " Present:       ", &ps_sw_presenttime, PS_TIME|PS_SW},
 	{0}
 };
 
@@ -123,6 +127,12 @@ perfstatrow_t commoncounter_rows[] = {
 	{"sprites", "Sprites:     ", &ps_numsprites, 0},
 	{"drwnode", "Drawnodes:   ", &ps_numdrawnodes, 0},
 	{"plyobjs", "Polyobjects: ", &ps_numpolyobjects, 0},
+	{"visplns", "Visplanes:   ", &ps_sw_numvisplanes, PS_SW},
+	{"plnspan", "Plane spans: ", &ps_sw_numplanespans, PS_SW},
+	{"spanlen", "Avg span:    ", &ps_sw_planespanlength, PS_SW},
+	{"dsclips", "Segs/sprite: ", &ps_sw_drawsegspersprite, PS_SW},
+	{"rotated", "Rotations:   ", &ps_sw_numrotations, PS_SW},
+	{"rotmemk", "Rotated KB:  ", &ps_sw_rotspritememory, PS_SW},
 	{0}
 };
 
@@ -173,7 +183,6 @@ perfstatrow_t thinkercount_rows[] = {
 	{"  regular", "  Regular:        ", &ps_regularcount, PS_LEVEL},
 	{"  scenery", "  Scenery:        ", &ps_scenerycount, PS_LEVEL},
 	{"  nothink", "  Nothink:        ", &ps_nothinkcount, PS_HIDE_ZERO|PS_LEVEL},
-	{" precip ", " Precipitation:  ", &ps_precipcount, PS_LEVEL},
 	{" other  ", " Other:          ", &ps_otherthcount, PS_LEVEL},
 	{" remove ", " Pending removal:", &ps_removecount, PS_LEVEL},
 	{0}
@@ -182,6 +191,7 @@ perfstatrow_t thinkercount_rows[] = {
 perfstatrow_t misc_calls_rows[] = {
 	{"lmhook", "Lua mobj hooks: ", &ps_lua_mobjhooks, PS_LEVEL},
 	{"chkpos", "P_CheckPosition:", &ps_checkposition_calls, PS_LEVEL},
+	{"dynslp", "Slope updates:  ", &ps_dynslopes_updated, PS_LEVEL},
 	{0}
 };
 
@@ -207,6 +217,11 @@ ps_hookinfo_t *postthinkframe_hooks = NULL;
 int postthinkframe_hooks_length = 0;
 int postthinkframe_hooks_capacity = 16;
 
+// per-polyobject movement times, collected every tick
+ps_hookinfo_t *polyobj_times = NULL;
+int polyobj_times_length = 0;
+int polyobj_times_capacity = 0;
+
 void PS_SetPreThinkFrameHookInfo(int index, precise_t time_taken, char* short_src)
 {
 	if (!prethinkframe_hooks)
@@ -284,6 +299,31 @@ void PS_SetPostThinkFrameHookInfo(int index, precise_t time_taken, char* short_s
 
 
 
+// Collects and resets the time each polyobject spent moving this tick.
+static void PS_CollectPolyobjTimes(void)
+{
+	int i;
+
+	if (numPolyObjects > polyobj_times_capacity)
+	{
+		polyobj_times = Z_Realloc(polyobj_times,
+			sizeof(ps_hookinfo_t) * numPolyObjects, PU_STATIC, NULL);
+		// initialize new memory with zeros so the pointers in the structs are null
+		memset(&polyobj_times[polyobj_times_capacity], 0,
+			sizeof(ps_hookinfo_t) * (numPolyObjects - polyobj_times_capacity));
+		polyobj_times_capacity = numPolyObjects;
+	}
+
+	for (i = 0; i < numPolyObjects; i++)
+	{
+		polyobj_times[i].time_taken.value.p = PolyObjects[i].movetime;
+		snprintf(polyobj_times[i].short_src, LUA_IDSIZE, "Polyobject %d", PolyObjects[i].id);
+		PolyObjects[i].movetime = 0;
+	}
+
+	polyobj_times_length = numPolyObjects;
+}
+
 static boolean PS_HighResolution(void)
 {
 	return (vid.width >= 640 && vid.height >= 400);
@@ -528,6 +568,7 @@ static void PS_UpdateFrameStats(void)
 		else
 #endif
 		{
+			// sprite sorting happens inside R_DrawMasked, so it is already counted
 			ps_otherrendertime.value.p -=
 				ps_skyboxtime.value.p +
 				ps_sw_spritecliptime.value.p +
@@ -572,13 +613,11 @@ static void PS_CountThinkers(void)
 	ps_regularcount.value.i = 0;
 	ps_scenerycount.value.i = 0;
 	ps_nothinkcount.value.i = 0;
-	ps_precipcount.value.i = 0;
 	ps_otherthcount.value.i = 0;
 	ps_removecount.value.i = 0;
 	for (thinker = thinkercap.next; thinker != &thinkercap; thinker = thinker->next)
 	{
-		if (thinker->function.acp1 != (actionf_p1)P_NullPrecipThinker)
-			ps_thinkercount.value.i++;
+		ps_thinkercount.value.i++;
 
 		if (thinker->function.acp1 == (actionf_p1)P_RemoveThinkerDelayed)
 			ps_removecount.value.i++;
@@ -593,8 +632,6 @@ static void PS_CountThinkers(void)
 			else
 				ps_regularcount.value.i++;
 		}
-		else if (thinker->function.acp1 == (actionf_p1)P_NullPrecipThinker)
-			ps_precipcount.value.i++;
 		else
 			ps_otherthcount.value.i++;
 	}
@@ -662,6 +699,13 @@ void PS_UpdateTickStats(void)
 			PS_UpdateRowHistories(misc_calls_rows, false);
 		}
 	}
+	if (cv_perfstats.value == 6)
+	{
+		if (PS_IsLevelActive())
+			PS_CollectPolyobjTimes();
+		else
+			polyobj_times_length = 0;
+	}
 	if (cv_ps_samplesize.value > 1)
 	{
 		if(cv_perfstats.value >= 3 && PS_IsLevelActive())
@@ -682,6 +726,11 @@ void PS_UpdateTickStats(void)
 				for (i = 0; i < postthinkframe_hooks_length; i++)
 					PS_UpdateMetricHistory(&postthinkframe_hooks[i].time_taken, true, false, false);
 			}
+			else if (cv_perfstats.value == 6)
+			{
+				for (i = 0; i < polyobj_times_length; i++)
+					PS_UpdateMetricHistory(&polyobj_times[i].time_taken, true, false, false);
+			}
 		}
 		if (cv_perfstats.value)
 		{
@@ -852,6 +901,13 @@ static void draw_think_frame_stats(int hook_length, ps_hookinfo_t *hook)
 		V_DrawSmallString(MAX_X-65, MAX_Y+2*HEIGHT, V_MONOSPACE | V_GREENMAP, "PostThinkFrame");
 
 	}
+	else if (cv_perfstats.value == 6){
+		maxpage = polyobj_times_length/PAGE_ENTRIES + 1;
+		page = max(1, min(cv_ps_thinkframe_page.value, maxpage));
+		pagestart = min((page - 1)*PAGE_ENTRIES, polyobj_times_length);
+		pageend   = min(pagestart + PAGE_ENTRIES, polyobj_times_length);
+		V_DrawSmallString(MAX_X-55, MAX_Y+2*HEIGHT, V_MONOSPACE | V_GREENMAP, "Polyobjects");
+	}
 	
 	PS_DrawDescriptorHeader();
 
@@ -959,6 +1015,11 @@ static void PS_DrawPostThinkFrameStats(void)
 	draw_think_frame_stats(postthinkframe_hooks_length, postthinkframe_hooks);
 }
 
+static void PS_DrawPolyobjStats(void)
+{
+	draw_think_frame_stats(polyobj_times_length, polyobj_times);
+}
+
 
 void M_DrawPerfStats(void)
 {
@@ -998,6 +1059,10 @@ void M_DrawPerfStats(void)
 		{
 			PS_DrawPostThinkFrameStats();
 		}
+		else if (cv_perfstats.value == 6)
+		{
+			PS_DrawPolyobjStats();
+		}
 
 	}
 }
@@ -1021,6 +1086,10 @@ static void PS_ClearHistory(void)
 	{
 		postthinkframe_hooks[i].time_taken.history = NULL;
 	}
+	for (i = 0; i < polyobj_times_capacity; i++)
+	{
+		polyobj_times[i].time_taken.history = NULL;
+	}
 
 	ps_frame_index = ps_tick_index = 0;
 	// PS_UpdateMetricHistory will set these correctly when it runs
@@ -43,6 +43,7 @@ extern ps_metric_t ps_thinkertime;
 extern ps_metric_t ps_thlist_times[];
 
 extern ps_metric_t ps_checkposition_calls;
+extern ps_metric_t ps_dynslopes_updated;
 
 extern ps_metric_t ps_lua_prethinkframe_time;
 extern ps_metric_t ps_lua_thinkframe_time;
@@ -0,0 +1,387 @@
+// SONIC ROBO BLAST 2 KART
+//-----------------------------------------------------------------------------
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+/// \file  m_rawvideo.c
+/// \brief Raw video movie mode, for piping to an external encoder.
+///        Writes uncompressed YUV4MPEG2 video at one frame per tic, and
+///        the mixer output as raw 16-bit stereo PCM alongside it. Either
+///        file can be a named pipe, e.g.
+///        ffmpeg -i video.y4m -f s16le -ar 44100 -ac 2 -i audio.pcm out.mkv
+
+#include "m_rawvideo.h"
+#include "d_main.h"
+#include "g_game.h"
+#include "v_video.h"
+#include "i_video.h"
+#include "i_sound.h"
+#include "i_system.h"
+#include "i_threads.h"
+#include "st_stuff.h"
+
+#ifdef HWRENDER
+#include "hardware/hw_main.h"
+#endif
+
+#include <signal.h>
+
+consvar_t cv_y4m_path = {"y4m_path", "", CV_SAVE, NULL, NULL, 0, NULL, NULL, 0, 0, NULL};
+consvar_t cv_y4m_audiopath = {"y4m_audiopath", "", CV_SAVE, NULL, NULL, 0, NULL, NULL, 0, 0, NULL};
+
+static FILE *y4m_out = NULL;
+static FILE *y4m_audioout = NULL;
+static INT32 y4m_width, y4m_height;
+static UINT32 y4m_frames = 0;
+static tic_t y4m_lasttic;
+static UINT8 *y4m_frame = NULL; // Y, U and V planes, one after another
+
+#ifdef SIGPIPE
+// An encoder closing its end of a pipe would kill the game with SIGPIPE,
+// so it's ignored while recording, and a failed write stops the movie.
+static void (*y4m_oldsigpipe)(int);
+#endif
+
+// CAPTURED AUDIO
+// ---
+// The mixer hands us its output from the audio thread, a whole mixer
+// chunk at a time, and it sits in a ring until it's written out with the
+// video frame it goes with, exactly one tic's worth each. A chunk is
+// usually longer than a tic, so a frame's audio is only written once a
+// chunk more than it is buffered, and the audio file trails the video by
+// a few frames. Silence only fills in when the audio falls a long way
+// behind, like in a timedemo, and the ring only skips ahead when the game
+// falls several chunks behind the mixer.
+
+#define Y4MAUDIORING 131072 // INT16s, so about 1.5 seconds of stereo
+#define Y4MAUDIOWAIT TICRATE // most frames the audio can trail before silence fills in
+#define Y4MAUDIOSLACK 4 // chunks (or tics, if longer) behind before skipping ahead
+
+static INT32 y4m_samplerate = 0;
+static INT16 *y4m_audioring = NULL;
+static size_t y4m_audiohead = 0, y4m_audiotail = 0;
+static size_t y4m_audiochunk = 0; // INT16s in the biggest chunk the mixer has sent
+static INT16 *y4m_audiotic = NULL;
+static UINT32 y4m_audioframes = 0; // video frames that have their audio written
+
+#ifdef HAVE_THREADS
+static I_mutex y4m_audiomutex;
+
+static void Y4M_audiocapture(const INT16 *samples, size_t numsamples)
+{
+	size_t i;
+
+	I_lock_mutex(&y4m_audiomutex);
+	if (numsamples > y4m_audiochunk)
+		y4m_audiochunk = numsamples;
+	for (i = 0; i < numsamples; i++)
+	{
+		if (y4m_audiohead - y4m_audiotail >= Y4MAUDIORING)
+			break; // the game isn't keeping up, so drop it
+		y4m_audioring[y4m_audiohead++ % Y4MAUDIORING] = samples[i];
+	}
+	I_unlock_mutex(y4m_audiomutex);
+}
+#endif
+
+// Samples that go with one video frame. Counted in whole samples from the
+// start, so rounding never drifts.
+static size_t Y4M_audiocount(UINT32 frame)
+{
+	return 2 * (size_t)(
+		((UINT64)(frame + 1) * y4m_samplerate / TICRATE) -
+		((UINT64)frame * y4m_samplerate / TICRATE));
+}
+
+//
+// Y4M_audiotake
+// takes the next video frame's audio out of the ring, or returns 0 to
+// wait for more; flush takes it even if it has to be padded with silence
+//
+static size_t Y4M_audiotake(boolean flush)
+{
+	const size_t count = Y4M_audiocount(y4m_audioframes);
+	size_t i, have;
+
+#ifdef HAVE_THREADS
+	I_lock_mutex(&y4m_audiomutex);
+#endif
+	have = y4m_audiohead - y4m_audiotail;
+
+	// Keep a chunk buffered, unless the audio has fallen too far behind.
+	if (!flush && (!y4m_audiochunk || have < count + y4m_audiochunk)
+		&& y4m_frames - y4m_audioframes <= Y4MAUDIOWAIT)
+	{
+#ifdef HAVE_THREADS
+		I_unlock_mutex(y4m_audiomutex);
+#endif
+		return 0;
+	}
+
+	// Running a long way behind the mixer? Skip ahead to a chunk behind,
+	// or the sound ends up out of sync with the picture.
+	if (have > count + min(Y4MAUDIOSLACK * max(y4m_audiochunk, count), Y4MAUDIORING / 2))
+	{
+		y4m_audiotail = y4m_audiohead - (count + y4m_audiochunk);
+		have = count + y4m_audiochunk;
+	}
+
+	have = min(have, count);
+	for (i = 0; i < have; i++)
+		y4m_audiotic[i] = y4m_audioring[y4m_audiotail++ % Y4MAUDIORING];
+#ifdef HAVE_THREADS
+	I_unlock_mutex(y4m_audiomutex);
+#endif
+
+	// Ran dry? Silence fills the gap.
+	memset(y4m_audiotic + have, 0, (count - have) * sizeof (INT16));
+
+	y4m_audioframes++;
+	return count;
+}
+
+//
+// Y4M_audiowrite
+// writes the audio of every video frame so far that's ready
+//
+static boolean Y4M_audiowrite(boolean flush)
+{
+	size_t count;
+
+	if (!y4m_audioout)
+		return true;
+
+	while (y4m_audioframes < y4m_frames && (count = Y4M_audiotake(flush)) != 0)
+	{
+		if (fwrite(y4m_audiotic, sizeof (INT16), count, y4m_audioout) != count)
+			return false;
+	}
+
+	return true;
+}
+
+// CONVERT to YUV
+// ---
+// BT.601, limited range, which is what encoders assume of Y4M unless told
+// otherwise. Chroma is kept at full resolution (4:4:4) so palette
+// colours don't bleed.
+
+#define Y4M_Y(r, g, b) (UINT8)((( 66*(r) + 129*(g) +  25*(b) + 128) >> 8) + 16)
+#define Y4M_U(r, g, b) (UINT8)(((-38*(r) -  74*(g) + 112*(b) + 128) >> 8) + 128)
+#define Y4M_V(r, g, b) (UINT8)(((112*(r) -  94*(g) -  18*(b) + 128) >> 8) + 128)
+
+//
+// Y4M_convertpalette
+// converts the software screen, straight out of the framebuffer
+//
+static void Y4M_convertpalette(void)
+{
+	const size_t size = (size_t)y4m_width * y4m_height;
+	UINT8 lumalut[256], ulut[256], vlut[256];
+	UINT8 *yp = y4m_frame, *up = yp + size, *vp = up + size;
+	const UINT8 *src;
+	INT32 x, y, j;
+
+	for (j = 0; j < 256; j++)
+	{
+		RGBA_t locpal = pLocalPalette[(max(st_palette,0)*256)+j];
+		lumalut[j] = Y4M_Y(locpal.s.red, locpal.s.green, locpal.s.blue);
+		ulut[j] = Y4M_U(locpal.s.red, locpal.s.green, locpal.s.blue);
+		vlut[j] = Y4M_V(locpal.s.red, locpal.s.green, locpal.s.blue);
+	}
+
+	for (y = 0; y < y4m_height; y++)
+	{
+		src = screens[0] + (size_t)y * vid.rowbytes;
+		for (x = 0; x < y4m_width; x++)
+		{
+			*yp++ = lumalut[src[x]];
+			*up++ = ulut[src[x]];
+			*vp++ = vlut[src[x]];
+		}
+	}
+}
+
+#ifdef HWRENDER
+//
+// Y4M_convertrgb
+// converts an RGB888 screenshot
+//
+static void Y4M_convertrgb(const UINT8 *src)
+{
+	const size_t size = (size_t)y4m_width * y4m_height;
+	UINT8 *yp = y4m_frame, *up = yp + size, *vp = up + size;
+	size_t i;
+
+	for (i = 0; i < size; i++, src += 3)
+	{
+		*yp++ = Y4M_Y(src[0], src[1], src[2]);
+		*up++ = Y4M_U(src[0], src[1], src[2]);
+		*vp++ = Y4M_V(src[0], src[1], src[2]);
+	}
+}
+#endif
+
+// PUBLIC FUNCTIONS
+// ---
+
+//
+// Y4M_open
+// starts writing video to filename, and audio to audiofilename
+//
+INT32 Y4M_open(const char *filename, const char *audiofilename)
+{
+	y4m_out = fopen(filename, "wb");
+	if (!y4m_out)
+		return 0;
+
+	y4m_width = vid.width;
+	y4m_height = vid.height;
+	y4m_frames = 0;
+	y4m_lasttic = gametic - 1; // the frame on screen now is the first one
+
+	y4m_frame = malloc((size_t)y4m_width * y4m_height * 3);
+	if (!y4m_frame)
+	{
+		fclose(y4m_out);
+		y4m_out = NULL;
+		return 0;
+	}
+
+	fprintf(y4m_out, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C444\n", y4m_width, y4m_height, TICRATE);
+
+#ifdef HAVE_THREADS
+	y4m_audioring = malloc(Y4MAUDIORING * sizeof (INT16));
+	y4m_audiotic = malloc((2 * 48000 / TICRATE + 2) * sizeof (INT16));
+	if (y4m_audioring && y4m_audiotic)
+	{
+		y4m_audioout = fopen(audiofilename, "wb");
+		if (!y4m_audioout)
+			CONS_Alert(CONS_WARNING, M_GetText("Couldn't write audio to %s\n"), audiofilename);
+		else
+		{
+			y4m_audiohead = y4m_audiotail = 0;
+			y4m_audiochunk = 0;
+			y4m_audioframes = 0;
+			y4m_samplerate = I_SetAudioCapture(Y4M_audiocapture);
+			if (y4m_samplerate <= 0 || y4m_samplerate > 48000)
+			{
+				I_SetAudioCapture(NULL);
+				fclose(y4m_audioout);
+				y4m_audioout = NULL;
+				remove(audiofilename);
+			}
+		}
+	}
+#else
+	(void)audiofilename;
+#endif
+
+#ifdef SIGPIPE
+	y4m_oldsigpipe = signal(SIGPIPE, SIG_IGN);
+#endif
+
+	if (y4m_audioout)
+		CONS_Printf(M_GetText("Writing audio as %d Hz 16-bit stereo PCM\n"), y4m_samplerate);
+	else
+		CONS_Alert(CONS_NOTICE, M_GetText("This movie will have no audio\n"));
+
+	return 1;
+}
+
+//
+// Y4M_frame
+// writes the current screen, once for every tic since the last one,
+// so the video stays at TICRATE no matter how fast frames are drawn
+//
+INT32 Y4M_frame(void)
+{
+	tic_t tics;
+
+	if (!y4m_out)
+		return 1;
+
+	if (gametic == y4m_lasttic)
+		return 1;
+	tics = gametic - y4m_lasttic;
+	y4m_lasttic = gametic;
+
+	// The stream can't change size halfway through.
+	if (vid.width != y4m_width || vid.height != y4m_height)
+		return 1;
+
+	if (rendermode == render_soft)
+		Y4M_convertpalette();
+#ifdef HWRENDER
+	else if (rendermode == render_opengl)
+	{
+		const UINT8 *screenshot = HWR_GetScreenshot();
+		if (!screenshot)
+		{
+			CONS_Alert(CONS_ERROR, M_GetText("Couldn't read the screen for the video frame\n"));
+			return 0;
+		}
+		Y4M_convertrgb(screenshot);
+	}
+#endif
+	else
+		return 1;
+
+	// A hitch shows up as a held frame rather than a short video.
+	while (tics--)
+	{
+		if (fputs("FRAME\n", y4m_out) == EOF
+		|| fwrite(y4m_frame, (size_t)y4m_width * y4m_height, 3, y4m_out) != 3)
+		{
+			CONS_Alert(CONS_ERROR, M_GetText("Couldn't write video frame, the encoder may have closed\n"));
+			return 0;
+		}
+		y4m_frames++;
+	}
+
+	if (!Y4M_audiowrite(false))
+	{
+		CONS_Alert(CONS_ERROR, M_GetText("Couldn't write audio, the encoder may have closed\n"));
+		return 0;
+	}
+
+	return 1;
+}
+
+//
+// Y4M_close
+// stops writing, and closes both files
+//
+INT32 Y4M_close(void)
+{
+	if (!y4m_out)
+		return 0;
+
+	if (y4m_audioout)
+	{
+		I_SetAudioCapture(NULL);
+
+		// The rest of the audio goes out now, so both streams are as long.
+		Y4M_audiowrite(true);
+
+		fclose(y4m_audioout);
+		y4m_audioout = NULL;
+	}
+
+	fclose(y4m_out);
+	y4m_out = NULL;
+
+#ifdef SIGPIPE
+	signal(SIGPIPE, y4m_oldsigpipe);
+#endif
+
+	free(y4m_frame);
+	free(y4m_audioring);
+	free(y4m_audiotic);
+	y4m_frame = NULL;
+	y4m_audioring = y4m_audiotic = NULL;
+
+	CONS_Printf(M_GetText("Y4M closed; wrote %u frames\n"), y4m_frames);
+	return 1;
+}
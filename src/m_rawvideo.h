@@ -0,0 +1,22 @@
+// SONIC ROBO BLAST 2 KART
+//-----------------------------------------------------------------------------
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+/// \file  m_rawvideo.h
+/// \brief Raw video movie mode, for piping to an external encoder.
+
+#ifndef __M_RAWVIDEO_H__
+#define __M_RAWVIDEO_H__
+
+#include "doomdef.h"
+#include "command.h"
+
+INT32 Y4M_open(const char *filename, const char *audiofilename);
+INT32 Y4M_frame(void);
+INT32 Y4M_close(void);
+
+extern consvar_t cv_y4m_path, cv_y4m_audiopath;
+
+#endif
@@ -333,25 +333,6 @@ boolean P_SetMobjStateNF(mobj_t *mobj, statenum_t state)
 	return true;
 }
 
-static boolean P_SetPrecipMobjState(precipmobj_t *mobj, statenum_t state)
-{
-	state_t *st;
-
-	if (state == S_NULL)
-	{ // Remove mobj
-		P_FreePrecipMobj(mobj);
-		return false;
-	}
-	st = &states[state];
-	mobj->state = st;
-	mobj->tics = st->tics;
-	mobj->sprite = st->sprite;
-	mobj->frame = st->frame;
-	mobj->anim_duration = (UINT16)st->var2; // only used if FF_ANIMATE is set
-
-	return true;
-}
-
 //
 // P_WeaponOrPanel
 //
@@ -3545,138 +3526,6 @@ animonly:
 	}
 }
 
-static void CalculatePrecipFloor(precipmobj_t *mobj)
-{
-	// recalculate floorz each time
-	const sector_t *mobjsecsubsec;
-	if (mobj && mobj->subsector && mobj->subsector->sector)
-		mobjsecsubsec = mobj->subsector->sector;
-	else
-		return;
-	mobj->floorz = P_GetSectorFloorZAt(mobjsecsubsec, mobj->x, mobj->y);
-	if (mobjsecsubsec->ffloors)
-	{
-		ffloor_t *rover;
-		fixed_t topheight;
-
-		for (rover = mobjsecsubsec->ffloors; rover; rover = rover->next)
-		{
-			// If it exists, it'll get rained on.
-			if (!(rover->flags & FF_EXISTS))
-				continue;
-
-			if (!(rover->flags & FF_BLOCKOTHERS) && !(rover->flags & FF_SWIMMABLE))
-				continue;
-
-			topheight = P_GetFFloorTopZAt(rover, mobj->x, mobj->y);;
-
-			if (topheight > mobj->floorz)
-				mobj->floorz = topheight;
-		}
-	}
-}
-
-void P_RecalcPrecipInSector(sector_t *sector)
-{
-	mprecipsecnode_t *psecnode;
-
-	if (!sector)
-		return;
-
-	sector->moved = true; // Recalc lighting and things too, maybe
-
-	for (psecnode = sector->touching_preciplist; psecnode; psecnode = psecnode->m_thinglist_next)
-		CalculatePrecipFloor(psecnode->m_thing);
-}
-
-//
-// P_NullPrecipThinker
-//
-// Just the identification of a precip thinker. The thinker
-// should never actually be called!
-//
-void P_NullPrecipThinker(precipmobj_t *mobj)
-{
-	(void)mobj;
-	I_Assert("P_NullPrecipThinker should not be called" == 0);
-}
-
-boolean P_PrecipThinker(precipmobj_t *mobj)
-{
-	if (mobj->lastThink == leveltime)
-		return true; // already thinked this tick
-
-	mobj->lastThink = leveltime;
-
-	R_ResetPrecipitationMobjInterpolationState(mobj);
-	P_CycleStateAnimation((mobj_t *)mobj);
-
-	if (mobj->state == &states[S_RAINRETURN])
-	{
-		// Reset to ceiling!
-		if (!P_SetPrecipMobjState(mobj, mobj->info->spawnstate))
-			return false;
-
-		mobj->z = mobj->ceilingz;
-		mobj->momz = cv_mobjscaleprecip.value ? FixedMul(mobj->info->speed, mapobjectscale) : mobj->info->speed;
-		mobj->precipflags &= ~PCF_SPLASH;
-		R_ResetPrecipitationMobjInterpolationState(mobj);
-	}
-
-	if (mobj->tics != -1)
-	{
-		if (mobj->tics)
-		{
-			mobj->tics--;
-		}
-
-		if (mobj->tics == 0)
-		{
-			if ((mobj->precipflags & PCF_SPLASH) && (mobj->state->nextstate == S_NULL))
-			{
-				// HACK: sprite changes are 1 tic late, so you would see splashes on the ceiling if not for this state.
-				// We need to use the settings from the previous state, since some of those are NOT 1 tic late.
-				INT32 frame = (mobj->frame & ~FF_FRAMEMASK);
-
-				if (!P_SetPrecipMobjState(mobj, S_RAINRETURN))
-					return false;
-
-				mobj->frame = frame;
-				return true;
-			}
-			else
-			{
-				if (!P_SetPrecipMobjState(mobj, mobj->state->nextstate))
-					return false;
-			}
-		}
-	}
-
-	if (mobj->precipflags & PCF_SPLASH)
-		return true;
-
-	// adjust height
-	if ((mobj->z += mobj->momz) <= mobj->floorz)
-	{
-		if ((mobj->info->deathstate == S_NULL) || (mobj->precipflags & PCF_PIT)) // no splashes on sky or bottomless pits
-		{
-			mobj->z = mobj->ceilingz;
-			R_ResetPrecipitationMobjInterpolationState(mobj);
-		}
-		else
-		{
-			if (!P_SetPrecipMobjState(mobj, mobj->info->deathstate))
-				return false;
-
-			mobj->z = mobj->floorz;
-			mobj->precipflags |= PCF_SPLASH;
-			R_ResetPrecipitationMobjInterpolationState(mobj);
-		}
-	}
-
-	return true;
-}
-
 static void P_RingThinker(mobj_t *mobj)
 {
 	if (mobj->momx || mobj->momy)
@@ -9931,59 +9780,6 @@ mobj_t *P_SpawnShadowMobj(mobj_t * caster)
 	return mobj;
 }
 
-static precipmobj_t *P_SpawnPrecipMobj(fixed_t x, fixed_t y, fixed_t z, mobjtype_t type)
-{
-	const mobjinfo_t *info = &mobjinfo[type];
-	state_t *st;
-	precipmobj_t *mobj = Z_Calloc(sizeof (*mobj), PU_LEVEL, NULL);
-	fixed_t starting_floorz;
-
-	mobj->type = type;
-	mobj->info = info;
-
-	mobj->x = x;
-	mobj->y = y;
-	mobj->flags = info->flags;
-
-	// do not set the state with P_SetMobjState,
-	// because action routines can not be called yet
-	st = &states[info->spawnstate];
-
-	mobj->state = st;
-	mobj->tics = st->tics;
-	mobj->sprite = st->sprite;
-	mobj->frame = st->frame; // FF_FRAMEMASK for frame, and other bits..
-	mobj->anim_duration = (UINT16)st->var2; // only used if FF_ANIMATE is set
-
-	// set subsector and/or block links
-	P_SetPrecipitationThingPosition(mobj);
-
-	mobj->floorz   = starting_floorz = P_GetSectorFloorZAt  (mobj->subsector->sector, x, y);
-	mobj->ceilingz                   = P_GetSectorCeilingZAt(mobj->subsector->sector, x, y);
-
-	mobj->z = z;
-	mobj->momz = cv_mobjscaleprecip.value ? FixedMul(info->speed, mapobjectscale) : info->speed;
-
-	mobj->thinker.function.acp1 = (actionf_p1)P_NullPrecipThinker;
-	P_AddThinker(&mobj->thinker);
-
-	CalculatePrecipFloor(mobj);
-
-	if (mobj->floorz != starting_floorz)
-		mobj->precipflags |= PCF_FOF;
-	else
-	{
-		INT32 special = GETSECSPECIAL(mobj->subsector->sector->special, 1);
-
-		if (special == 7 || special == 6 || mobj->subsector->sector->floorpic == skyflatnum)
-			mobj->precipflags |= PCF_PIT;
-	}
-
-	R_ResetPrecipitationMobjInterpolationState(mobj);
-
-	return mobj;
-}
-
 //
 // P_RemoveMobj
 //
@@ -10120,48 +9916,17 @@ void P_RemoveMobj(mobj_t *mobj)
 	}
 }
 
-void P_FreePrecipMobj(precipmobj_t *mobj)
-{
-	// unlink from sector and block lists
-	P_UnsetPrecipThingPosition(mobj);
-
-	if (precipsector_list)
-	{
-		P_DelPrecipSeclist(precipsector_list);
-		precipsector_list = NULL;
-	}
-
-	// free block
-	// Precipmobjs don't actually think using their thinker,
-	// so the free cannot be delayed.
-	P_UnlinkThinker((thinker_t*)mobj);
-}
-
 // Clearing out stuff for savegames
 void P_RemoveSavegameMobj(mobj_t *mobj)
 {
 	// unlink from sector and block lists
-	if (((thinker_t *)mobj)->function.acp1 == (actionf_p1)P_NullPrecipThinker)
-	{
-		P_UnsetPrecipThingPosition((precipmobj_t *)mobj);
+	P_UnsetThingPosition(mobj);
 
-		if (precipsector_list)
-		{
-			P_DelPrecipSeclist(precipsector_list);
-			precipsector_list = NULL;
-		}
-	}
-	else
+	// Remove touching_sectorlist from mobj.
+	if (sector_list)
 	{
-		// unlink from sector and block lists
-		P_UnsetThingPosition(mobj);
-
-		// Remove touching_sectorlist from mobj.
-		if (sector_list)
-		{
-			P_DelSeclist(sector_list);
-			sector_list = NULL;
-		}
+		P_DelSeclist(sector_list);
+		sector_list = NULL;
 	}
 
 	// stop any playing sound
@@ -10180,86 +9945,312 @@ static CV_PossibleValue_t flagtime_cons_t[] = {{0, "MIN"}, {300, "MAX"}, {0, NUL
 consvar_t cv_flagtime = {"flagtime", "30", CV_NETVAR|CV_CHEAT|CV_NOSHOWHELP, flagtime_cons_t, NULL, 0, NULL, NULL, 0, 0, NULL};
 consvar_t cv_suddendeath = {"suddendeath", "Off", CV_NETVAR|CV_CHEAT|CV_NOSHOWHELP, CV_OnOff, NULL, 0, NULL, NULL, 0, 0, NULL};
 
-void P_SpawnPrecipitation(void)
+//
+// Procedural precipitation
+//
+// Weather isn't made of objects. Each blockmap cell near the view holds
+// a few drops whose spot and fall phase come from hashing the cell, so
+// where a drop is can be worked out from the level time alone. The sector
+// checks a drop needs are cached in a small grid that wraps around the
+// view, and drops only become precipmobj_ts while the renderer projects
+// them.
+//
+#define PRECIPCACHEWRAP 63 // the cache is a 64x64 cell window
+#define PRECIPCACHECELLS ((PRECIPCACHEWRAP+1)*(PRECIPCACHEWRAP+1))
+
+typedef struct
+{
+	INT32 key; // cell * precipslots + slot, -1 when unused
+	UINT32 gen; // precipgen when floorz was last worked out
+	UINT32 phase; // tics into the fall at leveltime 0
+	subsector_t *subsector; // NULL if nothing falls here
+	fixed_t x, y;
+	fixed_t floorz, ceilingz;
+	UINT8 precipflags;
+	UINT8 variant; // snowflake shape
+} precipcell_t;
+
+static precipcell_t *precipcache;
+static UINT32 *precipsectorgen; // precipgen when each sector's floor last moved
+static UINT32 precipgen;
+static INT32 precipslots;
+
+static precipmobj_t *precipdrops;
+static size_t maxprecipdrops;
+
+static UINT32 P_PrecipHash(UINT32 x)
+{
+	x ^= x >> 16;
+	x *= 0x7feb352dU;
+	x ^= x >> 15;
+	x *= 0x846ca68bU;
+	x ^= x >> 16;
+	return x;
+}
+
+static fixed_t P_PrecipFloorZ(const sector_t *sector, fixed_t x, fixed_t y)
+{
+	fixed_t floorz = P_GetSectorFloorZAt(sector, x, y);
+	ffloor_t *rover;
+	fixed_t topheight;
+
+	for (rover = sector->ffloors; rover; rover = rover->next)
+	{
+		// If it exists, it'll get rained on.
+		if (!(rover->flags & FF_EXISTS))
+			continue;
+
+		if (!(rover->flags & FF_BLOCKOTHERS) && !(rover->flags & FF_SWIMMABLE))
+			continue;
+
+		topheight = P_GetFFloorTopZAt(rover, x, y);
+
+		if (topheight > floorz)
+			floorz = topheight;
+	}
+
+	return floorz;
+}
+
+static void P_FillPrecipCell(precipcell_t *cell, INT32 key)
 {
-	INT32 i, mrand;
-	fixed_t basex, basey, j, x, y, z;
-	subsector_t *precipsector = NULL;
-	precipmobj_t *rainmo = NULL;
+	const INT32 cellnum = key / precipslots;
+	const UINT32 hash = P_PrecipHash((UINT32)key ^ ((UINT32)gamemap * 0x9e3779b9U));
+	const UINT32 hash2 = P_PrecipHash(hash);
+	sector_t *sector;
 
-	if (dedicated || !cv_drawdist_precip.value || curWeather == PRECIP_NONE) // SRB2Kart
+	cell->key = key;
+	cell->phase = hash2 >> 8;
+	cell->subsector = NULL;
+
+	// Fewer drops, spread out as thinly as the old spawner's 1.5x spacing did.
+	if (cv_lessprecip.value && (hash2 & 0xff) >= 114)
 		return;
 
-	// Use the blockmap to narrow down our placing patterns
-	for (i = 0; i < bmapwidth*bmapheight; ++i)
+	cell->x = bmaporgx + (cellnum % bmapwidth) * MAPBLOCKSIZE + (((fixed_t)(hash % (MAPBLOCKUNITS<<3))<<FRACBITS)>>3);
+	cell->y = bmaporgy + (cellnum / bmapwidth) * MAPBLOCKSIZE + (((fixed_t)((hash >> 16) % (MAPBLOCKUNITS<<3))<<FRACBITS)>>3);
+
+	if ((hash >> 26) < 16)
+		cell->variant = 2;
+	else if ((hash >> 26) < 36)
+		cell->variant = 1;
+	else
+		cell->variant = 0;
+
+	cell->subsector = R_IsPointInSubsector(cell->x, cell->y);
+
+	// No sector? Nothing falls here.
+	if (!cell->subsector)
+		return;
+
+	sector = cell->subsector->sector;
+
+	// Not in a sector with visible sky, or too small for reasonable precipitation.
+	if (sector->ceilingpic != skyflatnum
+		|| !(sector->floorheight <= sector->ceilingheight - (32<<FRACBITS)))
+		cell->subsector = NULL;
+}
+
+static void P_PrecipCellFloor(precipcell_t *cell)
+{
+	const sector_t *sector = cell->subsector->sector;
+	const fixed_t floorz = P_GetSectorFloorZAt(sector, cell->x, cell->y);
+
+	cell->floorz = P_PrecipFloorZ(sector, cell->x, cell->y);
+	cell->ceilingz = P_GetSectorCeilingZAt(sector, cell->x, cell->y);
+	cell->precipflags = 0;
+	cell->gen = precipgen;
+
+	if (cell->floorz != floorz)
+		cell->precipflags |= PCF_FOF;
+	else
 	{
-		basex = bmaporgx + (i % bmapwidth) * MAPBLOCKSIZE;
-		basey = bmaporgy + (i / bmapwidth) * MAPBLOCKSIZE;
+		INT32 special = GETSECSPECIAL(sector->special, 1);
 
-		for (j = 0; j < FRACUNIT; j += cv_mobjscaleprecip.value ? mapobjectscale : FRACUNIT)
-		{
-			INT32 floorz;
-			INT32 ceilingz;
+		if (special == 7 || special == 6 || sector->floorpic == skyflatnum)
+			cell->precipflags |= PCF_PIT;
+	}
+}
 
-			x = ((cv_lessprecip.value ? basex*1.5 : basex) + ((M_RandomKey(MAPBLOCKUNITS<<3)<<FRACBITS)>>3));
-			y = ((cv_lessprecip.value ? basey*1.5 : basey) + ((M_RandomKey(MAPBLOCKUNITS<<3)<<FRACBITS)>>3));
+static precipcell_t *P_GetPrecipCell(INT32 bx, INT32 by, INT32 slot)
+{
+	const INT32 key = ((by * bmapwidth) + bx) * precipslots + slot;
+	precipcell_t *cell = &precipcache[(((by & PRECIPCACHEWRAP) << 6) | (bx & PRECIPCACHEWRAP)) * precipslots + slot];
 
-			precipsector = R_IsPointInSubsector(x, y);
+	if (cell->key != key)
+	{
+		P_FillPrecipCell(cell, key);
+		if (cell->subsector)
+			P_PrecipCellFloor(cell);
+	}
+	else if (cell->subsector && cell->gen < precipsectorgen[cell->subsector->sector - sectors])
+		P_PrecipCellFloor(cell);
 
-			// No sector? Stop wasting time,
-			// move on to the next entry in the blockmap
-			if (!precipsector)
-				continue;
+	return cell;
+}
 
-			// Not in a sector with visible sky?
-			if (precipsector->sector->ceilingpic != skyflatnum)
-				continue;
+//
+// P_ResetPrecipitation
+//
+// Forgets every cached precipitation cell. They're worked out again the
+// next time they're drawn, so call this whenever drops should move.
+//
+void P_ResetPrecipitation(void)
+{
+	if (precipcache)
+		Z_Free(precipcache);
+	if (precipsectorgen)
+		Z_Free(precipsectorgen);
+}
 
-			// Exists, but is too small for reasonable precipitation.
-			if (!(precipsector->sector->floorheight <= precipsector->sector->ceilingheight - (32<<FRACBITS)))
-				continue;
+//
+// P_RecalcPrecipInSector
+//
+// A sector's floor moved, so drops need to find their floor again.
+//
+void P_RecalcPrecipInSector(sector_t *sector)
+{
+	if (!sector)
+		return;
 
-			// Don't set z properly yet...
-			z = precipsector->sector->ceilingheight;
+	sector->moved = true; // Recalc lighting and things too, maybe
 
-			if (curWeather == PRECIP_SNOW)
-			{
-				rainmo = P_SpawnPrecipMobj(x, y, z, MT_SNOWFLAKE);
-				mrand = M_RandomByte();
-				if (mrand < 64)
-					P_SetPrecipMobjState(rainmo, S_SNOW3);
-				else if (mrand < 144)
-					P_SetPrecipMobjState(rainmo, S_SNOW2);
-			}
-			else // everything else.
-				rainmo = P_SpawnPrecipMobj(x, y, z, MT_RAIN);
+	if (precipsectorgen)
+		precipsectorgen[sector - sectors] = ++precipgen;
+}
+
+//
+// P_GeneratePrecipitation
+//
+// Works out every drop falling in the given blockmap cells at the current
+// leveltime and returns how many there are. The drops stay valid until the
+// next call.
+//
+size_t P_GeneratePrecipitation(INT32 xl, INT32 xh, INT32 yl, INT32 yh, precipmobj_t **drops)
+{
+	const mobjtype_t type = (curWeather == PRECIP_SNOW) ? MT_SNOWFLAKE : MT_RAIN;
+	const mobjinfo_t *info = &mobjinfo[type];
+	fixed_t speed;
+	UINT32 splashtics = 0;
+	size_t numdrops = 0, needed;
+	statenum_t st;
+	INT32 bx, by, slot, i;
 
-			floorz = rainmo->floorz >> FRACBITS;
-			ceilingz = rainmo->ceilingz >> FRACBITS;
+	*drops = precipdrops;
 
-			if (floorz < ceilingz)
-			{
-				// Randomly assign a height, now that floorz is set.
-				rainmo->z = M_RandomRange(floorz, ceilingz) << FRACBITS;
-			}
-			else
-			{
-				// ...except if the floor is above the ceiling.
-				rainmo->z = ceilingz << FRACBITS;
-			}
-		}
+	if (curWeather == PRECIP_NONE || !bmapwidth || !bmapheight)
+		return 0;
+
+	xl = max(xl, 0);
+	yl = max(yl, 0);
+	xh = min(xh, bmapwidth - 1);
+	yh = min(yh, bmapheight - 1);
+
+	if (xl > xh || yl > yh)
+		return 0;
+
+	if (!precipcache)
+	{
+		// One drop per cell, or one per mapobjectscale with scaleprecipmobjscale.
+		precipslots = 1;
+		if (cv_mobjscaleprecip.value && mapobjectscale > 0 && mapobjectscale < FRACUNIT)
+			precipslots = (FRACUNIT + mapobjectscale - 1) / mapobjectscale;
+
+		// Every slot of every cell in the window gets its own entry.
+		Z_Malloc(PRECIPCACHECELLS * precipslots * sizeof (*precipcache), PU_LEVEL, &precipcache);
+		for (i = 0; i < PRECIPCACHECELLS * precipslots; i++)
+			precipcache[i].key = -1;
+
+		if (!precipsectorgen)
+			Z_Calloc(numsectors * sizeof (*precipsectorgen), PU_LEVEL, &precipsectorgen);
 	}
 
-	if (curWeather == PRECIP_BLANK)
+	needed = (size_t)(xh - xl + 1) * (size_t)(yh - yl + 1) * precipslots;
+	if (needed > maxprecipdrops)
 	{
-		curWeather = PRECIP_RAIN;
-		P_SwitchWeather(PRECIP_BLANK);
+		maxprecipdrops = needed;
+		precipdrops = Z_Realloc(precipdrops, maxprecipdrops * sizeof (*precipdrops), PU_STATIC, NULL);
+		*drops = precipdrops;
 	}
-	else if (curWeather == PRECIP_STORM_NORAIN)
+
+	speed = abs(cv_mobjscaleprecip.value ? FixedMul(info->speed, mapobjectscale) : info->speed);
+	if (speed <= 0)
+		speed = FRACUNIT;
+
+	// Splashes play out on the floor, then spend a tic out of sight
+	// before the drop starts over at the ceiling.
+	for (st = info->deathstate, i = 0; st != S_NULL && states[st].tics > 0 && i < 16; st = states[st].nextstate, i++)
+		splashtics += states[st].tics;
+	if (splashtics)
+		splashtics++;
+
+	for (by = yl; by <= yh; by++)
 	{
-		curWeather = PRECIP_RAIN;
-		P_SwitchWeather(PRECIP_STORM_NORAIN);
+		for (bx = xl; bx <= xh; bx++)
+		{
+			for (slot = 0; slot < precipslots; slot++)
+			{
+				const precipcell_t *cell = P_GetPrecipCell(bx, by, slot);
+				precipmobj_t *drop;
+				statenum_t state = info->spawnstate;
+				UINT32 falltics, period, phase;
+				fixed_t z, oldz;
+
+				if (!cell->subsector)
+					continue;
+
+				falltics = 1;
+				if (cell->ceilingz > cell->floorz)
+					falltics = ((UINT32)(cell->ceilingz - cell->floorz) + (UINT32)speed - 1) / (UINT32)speed;
+
+				period = falltics;
+				if (!(cell->precipflags & PCF_PIT)) // no splashes on sky or bottomless pits
+					period += splashtics;
+
+				phase = (leveltime + cell->phase) % period;
+
+				if (phase < falltics)
+				{
+					z = cell->ceilingz - (fixed_t)phase * speed;
+					oldz = phase ? z + speed : z;
+
+					if (type == MT_SNOWFLAKE)
+						state += cell->variant;
+				}
+				else
+				{
+					phase -= falltics;
+					if (phase == splashtics - 1)
+						continue;
+
+					for (state = info->deathstate; phase >= (UINT32)states[state].tics; state = states[state].nextstate)
+						phase -= states[state].tics;
+
+					z = oldz = cell->floorz;
+				}
+
+				drop = &precipdrops[numdrops++];
+				drop->type = type;
+				drop->info = info;
+				drop->flags = info->flags;
+				drop->x = drop->old_x = cell->x;
+				drop->y = drop->old_y = cell->y;
+				drop->z = z;
+				drop->old_z = oldz;
+				drop->subsector = cell->subsector;
+				drop->floorz = cell->floorz;
+				drop->ceilingz = cell->ceilingz;
+				drop->precipflags = cell->precipflags;
+				drop->state = &states[state];
+				drop->tics = states[state].tics;
+				drop->sprite = states[state].sprite;
+				drop->frame = states[state].frame;
+				drop->lastThink = leveltime;
+			}
+		}
 	}
+
+	return numdrops;
 }
 
 //
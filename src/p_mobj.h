@@ -391,6 +391,7 @@ typedef struct mobj_s
 	struct pslope_s *standingslope; // The slope that the object is standing on (shouldn't need synced in savegames, right?)
 
 	boolean resetinterp; // if true, some fields should not be interpolated (see R_InterpolateMobjState implementation)
+	size_t interpindex; // slot in the interpolated mobj list, see R_AddMobjInterpolator
 	boolean colorized; // Whether the mobj uses the rainbow colormap
 	boolean mirrored; // The object's rotations will be mirrored left to right, e.g., see frame AL from the right and AR from the left
 	boolean rollmodel; // OpenGL: Should this model rotate?
@@ -456,7 +457,7 @@ typedef struct precipmobj_s
 	angle_t old_sloperoll2, old_slopepitch2;
 	angle_t pitch_sprite, roll_sprite;
 
-	struct mprecipsecnode_s *touching_sectorlist; // a linked list of sectors where this object appears
+	void *touching_sectorlist; // unused, keeps the layout matching mobj_t
 
 	struct subsector_s *subsector; // Subsector the mobj resides in.
 
@@ -510,14 +511,12 @@ void P_AfterPlayerSpawn(INT32 playernum);
 void P_SpawnMapThing(mapthing_t *mthing);
 void P_SpawnHoopsAndRings(mapthing_t *mthing);
 void P_SpawnHoopOfSomething(fixed_t x, fixed_t y, fixed_t z, fixed_t radius, INT32 number, mobjtype_t type, angle_t rotangle);
-void P_SpawnPrecipitation(void);
+void P_ResetPrecipitation(void);
+size_t P_GeneratePrecipitation(INT32 xl, INT32 xh, INT32 yl, INT32 yh, precipmobj_t **drops);
 void P_SpawnParaloop(fixed_t x, fixed_t y, fixed_t z, fixed_t radius, INT32 number, mobjtype_t type, statenum_t nstate, angle_t rotangle, boolean spawncenter);
 boolean P_BossTargetPlayer(mobj_t *actor, boolean closest);
 boolean P_SupermanLook4Players(mobj_t *actor);
 void P_DestroyRobots(void);
-boolean P_PrecipThinker(precipmobj_t *mobj);
-void P_NullPrecipThinker(precipmobj_t *mobj);
-void P_FreePrecipMobj(precipmobj_t *mobj);
 void P_SetScale(mobj_t *mobj, fixed_t newscale);
 void P_XYMovement(mobj_t *mo);
 void P_EmeraldManager(void);
@@ -29,6 +29,7 @@
 #include "r_state.h"
 #include "r_defs.h"
 #include "qs22j.h"
+#include "d_netcmd.h" // cv_perfstats
 
 
 /*
@@ -864,6 +865,91 @@ static void Polyobj_putLink(polymaplink_t *l)
 	bmap_freelist = l;
 }
 
+//
+// Polyobj_calcBBox
+//
+// Recalculates the polyobject's bounding box from its vertices. Only needed
+// when the shape changes; plain translations just offset the cached box.
+//
+static void Polyobj_calcBBox(polyobj_t *po)
+{
+	fixed_t *bbox = po->bbox;
+	size_t i;
+
+	// 2/26/06: start line box with values of first vertex, not INT32_MIN/INT32_MAX
+	bbox[BOXLEFT]   = bbox[BOXRIGHT] = po->vertices[0]->x;
+	bbox[BOXBOTTOM] = bbox[BOXTOP]   = po->vertices[0]->y;
+
+	// add all vertices to the bounding box
+	for (i = 1; i < po->numVertices; ++i)
+		M_AddToBox(bbox, po->vertices[i]->x, po->vertices[i]->y);
+}
+
+//
+// Polyobj_bboxToBlocks
+//
+// Converts a map-space bounding box to blockmap cell coordinates.
+//
+static void Polyobj_bboxToBlocks(const fixed_t *bbox, fixed_t *blockbox)
+{
+	blockbox[BOXRIGHT]  = (unsigned)(bbox[BOXRIGHT]  - bmaporgx) >> MAPBLOCKSHIFT;
+	blockbox[BOXLEFT]   = (unsigned)(bbox[BOXLEFT]   - bmaporgx) >> MAPBLOCKSHIFT;
+	blockbox[BOXTOP]    = (unsigned)(bbox[BOXTOP]    - bmaporgy) >> MAPBLOCKSHIFT;
+	blockbox[BOXBOTTOM] = (unsigned)(bbox[BOXBOTTOM] - bmaporgy) >> MAPBLOCKSHIFT;
+}
+
+FUNCINLINE static ATTRINLINE boolean Polyobj_blockInBox(const fixed_t *blockbox, INT32 x, INT32 y)
+{
+	return (x >= blockbox[BOXLEFT] && x <= blockbox[BOXRIGHT]
+		&& y >= blockbox[BOXBOTTOM] && y <= blockbox[BOXTOP]);
+}
+
+//
+// Polyobj_linkToBlock
+//
+// Links a polyobject into a single blockmap cell.
+//
+static void Polyobj_linkToBlock(polyobj_t *po, INT32 x, INT32 y)
+{
+	polymaplink_t *l;
+
+	if (x < 0 || y < 0 || x >= bmapwidth || y >= bmapheight)
+		return;
+
+	l = Polyobj_getLink();
+	l->po = po;
+
+	M_DLListInsert(&l->link,
+				(mdllistitem_t **)(&polyblocklinks[y*bmapwidth + x]));
+}
+
+//
+// Polyobj_removeFromBlock
+//
+// Unlinks a polyobject from a single blockmap cell and returns its
+// polymaplink object to the free list.
+//
+static void Polyobj_removeFromBlock(polyobj_t *po, INT32 x, INT32 y)
+{
+	polymaplink_t *rover;
+
+	if (x < 0 || y < 0 || x >= bmapwidth || y >= bmapheight)
+		return;
+
+	rover = polyblocklinks[y * bmapwidth + x];
+
+	while (rover && rover->po != po)
+		rover = (polymaplink_t *)(rover->link.next);
+
+	// polyobject not in this cell? go on to next.
+	if (!rover)
+		return;
+
+	// remove this link from the blockmap and put it on the freelist
+	M_DLListRemove(&rover->link);
+	Polyobj_putLink(rover);
+}
+
 //
 // Polyobj_linkToBlockmap
 //
@@ -875,87 +961,65 @@ static void Polyobj_putLink(polymaplink_t *l)
 static void Polyobj_linkToBlockmap(polyobj_t *po)
 {
 	fixed_t *blockbox = po->blockbox;
-	size_t i;
 	fixed_t x, y;
 
 	// never link a bad polyobject or a polyobject already linked
 	if (po->isBad || po->linked)
 		return;
 
-	// 2/26/06: start line box with values of first vertex, not INT32_MIN/INT32_MAX
-	blockbox[BOXLEFT]   = blockbox[BOXRIGHT] = po->vertices[0]->x;
-	blockbox[BOXBOTTOM] = blockbox[BOXTOP]   = po->vertices[0]->y;
-
-	// add all vertices to the bounding box
-	for (i = 1; i < po->numVertices; ++i)
-		M_AddToBox(blockbox, po->vertices[i]->x, po->vertices[i]->y);
+	Polyobj_calcBBox(po);
 
 	// adjust bounding box relative to blockmap
-	blockbox[BOXRIGHT]  = (unsigned)(blockbox[BOXRIGHT]  - bmaporgx) >> MAPBLOCKSHIFT;
-	blockbox[BOXLEFT]   = (unsigned)(blockbox[BOXLEFT]   - bmaporgx) >> MAPBLOCKSHIFT;
-	blockbox[BOXTOP]    = (unsigned)(blockbox[BOXTOP]    - bmaporgy) >> MAPBLOCKSHIFT;
-	blockbox[BOXBOTTOM] = (unsigned)(blockbox[BOXBOTTOM] - bmaporgy) >> MAPBLOCKSHIFT;
+	Polyobj_bboxToBlocks(po->bbox, blockbox);
 
 	// link polyobject to every block its bounding box intersects
 	for (y = blockbox[BOXBOTTOM]; y <= blockbox[BOXTOP]; ++y)
-	{
 		for (x = blockbox[BOXLEFT]; x <= blockbox[BOXRIGHT]; ++x)
-		{
-			if (!(x < 0 || y < 0 || x >= bmapwidth || y >= bmapheight))
-			{
-				polymaplink_t  *l = Polyobj_getLink();
-
-				l->po = po;
-
-				M_DLListInsert(&l->link,
-							(mdllistitem_t **)(&polyblocklinks[y*bmapwidth + x]));
-			}
-		}
-	}
+			Polyobj_linkToBlock(po, x, y);
 
 	po->linked = true;
 }
 
 //
-// Polyobj_removeFromBlockmap
+// Polyobj_relinkToBlockmap
 //
-// Unlinks a polyobject from all blockmap cells it intersects and returns
-// its polymaplink objects to the free list.
+// Updates the blockmap cells of a moved polyobject from its (already
+// updated) bounding box. Only the cells it entered or left are touched,
+// and nothing is done at all if it stayed within the same cells.
 //
-static void Polyobj_removeFromBlockmap(polyobj_t *po)
+static void Polyobj_relinkToBlockmap(polyobj_t *po)
 {
-	polymaplink_t *rover;
 	fixed_t *blockbox = po->blockbox;
+	fixed_t newbox[4];
 	INT32 x, y;
 
-	// don't bother trying to unlink one that's not linked
-	if (!po->linked)
+	if (po->isBad)
 		return;
 
-	// search all cells the polyobject touches
-	for (y = blockbox[BOXBOTTOM]; y <= blockbox[BOXTOP]; ++y)
+	if (!po->linked)
 	{
-		for (x = blockbox[BOXLEFT]; x <= blockbox[BOXRIGHT]; ++x)
-		{
-			if (!(x < 0 || y < 0 || x >= bmapwidth || y >= bmapheight))
-			{
-				rover = polyblocklinks[y * bmapwidth + x];
+		Polyobj_linkToBlockmap(po);
+		return;
+	}
 
-				while (rover && rover->po != po)
-					rover = (polymaplink_t *)(rover->link.next);
+	Polyobj_bboxToBlocks(po->bbox, newbox);
 
-				// polyobject not in this cell? go on to next.
-				if (!rover)
-					continue;
+	if (!memcmp(newbox, blockbox, sizeof(newbox)))
+		return;
 
-				// remove this link from the blockmap and put it on the freelist
-				M_DLListRemove(&rover->link);
-				Polyobj_putLink(rover);
-			}
-		}
-	}
+	// leave cells no longer covered
+	for (y = blockbox[BOXBOTTOM]; y <= blockbox[BOXTOP]; ++y)
+		for (x = blockbox[BOXLEFT]; x <= blockbox[BOXRIGHT]; ++x)
+			if (!Polyobj_blockInBox(newbox, x, y))
+				Polyobj_removeFromBlock(po, x, y);
 
-	po->linked = false;
+	// enter newly covered cells
+	for (y = newbox[BOXBOTTOM]; y <= newbox[BOXTOP]; ++y)
+		for (x = newbox[BOXLEFT]; x <= newbox[BOXRIGHT]; ++x)
+			if (!Polyobj_blockInBox(blockbox, x, y))
+				Polyobj_linkToBlock(po, x, y);
+
+	memcpy(blockbox, newbox, sizeof(newbox));
 }
 
 // Movement functions
@@ -1110,6 +1174,98 @@ static void Polyobj_carryThings(polyobj_t *po, fixed_t dx, fixed_t dy)
 	}
 }
 
+//
+// Polyobject thing queries
+//
+// A moving polyobject checks every one of its lines against the things in
+// the blockmap cells around it, and most of the time there are none. The
+// cells are looked over once per movement step first, and the per-line
+// checks only run when something there could be hit. Those checks still
+// walk the live blockmap line by line, since a push can move a thing into
+// a cell a later line looks at, and demos depend on that order.
+//
+
+static UINT32 *polyblockstamps; // last step each blockmap cell was visited in
+static size_t numpolyblockstamps;
+static UINT32 polyblockstamp;
+
+//
+// Polyobj_lineBlockBox
+//
+// Gets the blockmap cells a line can contact things in.
+//
+static void Polyobj_lineBlockBox(line_t *line, fixed_t *linebox)
+{
+	// adjust linedef bounding box to blockmap, extend by MAXRADIUS
+	linebox[BOXLEFT]   = (unsigned)(line->bbox[BOXLEFT]   - bmaporgx - MAXRADIUS) >> MAPBLOCKSHIFT;
+	linebox[BOXRIGHT]  = (unsigned)(line->bbox[BOXRIGHT]  - bmaporgx + MAXRADIUS) >> MAPBLOCKSHIFT;
+	linebox[BOXBOTTOM] = (unsigned)(line->bbox[BOXBOTTOM] - bmaporgy - MAXRADIUS) >> MAPBLOCKSHIFT;
+	linebox[BOXTOP]    = (unsigned)(line->bbox[BOXTOP]    - bmaporgy + MAXRADIUS) >> MAPBLOCKSHIFT;
+}
+
+//
+// Polyobj_anyThings
+//
+// Checks whether any blockmap cell the polyobject's lines can contact has
+// something a line could hit, visiting each cell only once.
+//
+static boolean Polyobj_anyThings(polyobj_t *po)
+{
+	const size_t numblocks = (size_t)bmapwidth * bmapheight;
+	fixed_t linebox[4];
+	INT32 x, y;
+	size_t i;
+
+	if (!(po->flags & POF_SOLID))
+		return false;
+
+	if (!polyblockstamps || numpolyblockstamps != numblocks)
+	{
+		// blockmap changed, so did the level
+		Z_Free(polyblockstamps);
+		polyblockstamps = Z_Calloc(numblocks * sizeof (*polyblockstamps), PU_LEVEL, &polyblockstamps);
+		numpolyblockstamps = numblocks;
+		polyblockstamp = 0;
+	}
+
+	if (++polyblockstamp == 0)
+	{
+		// wrapped around, forget every old visit
+		memset(polyblockstamps, 0, numblocks * sizeof (*polyblockstamps));
+		polyblockstamp = 1;
+	}
+
+	for (i = 0; i < po->numLines; ++i)
+	{
+		Polyobj_lineBlockBox(po->lines[i], linebox);
+
+		for (y = linebox[BOXBOTTOM]; y <= linebox[BOXTOP]; ++y)
+		{
+			for (x = linebox[BOXLEFT]; x <= linebox[BOXRIGHT]; ++x)
+			{
+				mobj_t *mo;
+
+				if (x < 0 || y < 0 || x >= bmapwidth || y >= bmapheight)
+					continue;
+
+				if (polyblockstamps[y * bmapwidth + x] == polyblockstamp)
+					continue;
+
+				polyblockstamps[y * bmapwidth + x] = polyblockstamp;
+
+				for (mo = blocklinks[y * bmapwidth + x]; mo; mo = mo->bnext)
+				{
+					// Things that can never be hit don't count
+					if (!(mo->flags & (MF_NOGRAVITY|MF_NOCLIP)))
+						return true;
+				}
+			}
+		}
+	}
+
+	return false;
+}
+
 //
 // Polyobj_clipThings
 //
@@ -1125,11 +1281,7 @@ static INT32 Polyobj_clipThings(polyobj_t *po, line_t *line)
 	if (!(po->flags & POF_SOLID))
 		return hitflags;
 
-	// adjust linedef bounding box to blockmap, extend by MAXRADIUS
-	linebox[BOXLEFT]   = (unsigned)(line->bbox[BOXLEFT]   - bmaporgx - MAXRADIUS) >> MAPBLOCKSHIFT;
-	linebox[BOXRIGHT]  = (unsigned)(line->bbox[BOXRIGHT]  - bmaporgx + MAXRADIUS) >> MAPBLOCKSHIFT;
-	linebox[BOXBOTTOM] = (unsigned)(line->bbox[BOXBOTTOM] - bmaporgy - MAXRADIUS) >> MAPBLOCKSHIFT;
-	linebox[BOXTOP]    = (unsigned)(line->bbox[BOXTOP]    - bmaporgy + MAXRADIUS) >> MAPBLOCKSHIFT;
+	Polyobj_lineBlockBox(line, linebox);
 
 	// check all mobj blockmap cells the line contacts
 	for (y = linebox[BOXBOTTOM]; y <= linebox[BOXTOP]; ++y)
@@ -1187,6 +1339,7 @@ static boolean Polyobj_moveXY(polyobj_t *po, fixed_t x, fixed_t y)
 	size_t i;
 	vertex_t vec;
 	INT32 hitflags = 0;
+	precise_t starttime = 0;
 
 	vec.x = x;
 	vec.y = y;
@@ -1195,6 +1348,9 @@ static boolean Polyobj_moveXY(polyobj_t *po, fixed_t x, fixed_t y)
 	if (po->isBad)
 		return false;
 
+	if (cv_perfstats.value == 6)
+		starttime = I_GetPreciseTime();
+
 	// translate vertices
 	for (i = 0; i < po->numVertices; ++i)
 		Polyobj_vecAdd(po->vertices[i], &vec);
@@ -1204,8 +1360,11 @@ static boolean Polyobj_moveXY(polyobj_t *po, fixed_t x, fixed_t y)
 		Polyobj_bboxAdd(po->lines[i]->bbox, &vec);
 
 	// check for blocking things (yes, it needs to be done separately)
-	for (i = 0; i < po->numLines; ++i)
-		hitflags |= Polyobj_clipThings(po, po->lines[i]);
+	if (Polyobj_anyThings(po))
+	{
+		for (i = 0; i < po->numLines; ++i)
+			hitflags |= Polyobj_clipThings(po, po->lines[i]);
+	}
 
 	if (hitflags & 2)
 	{
@@ -1223,13 +1382,18 @@ static boolean Polyobj_moveXY(polyobj_t *po, fixed_t x, fixed_t y)
 		po->spawnSpot.x += vec.x;
 		po->spawnSpot.y += vec.y;
 
+		// a translation doesn't change the shape
+		Polyobj_bboxAdd(po->bbox, &vec);
+
 		Polyobj_carryThings(po, x, y);
-		Polyobj_removeFromBlockmap(po); // unlink it from the blockmap
+		Polyobj_relinkToBlockmap(po);   // relink to blockmap
 		Polyobj_removeFromSubsec(po);   // unlink it from its subsector
-		Polyobj_linkToBlockmap(po);     // relink to blockmap
 		Polyobj_attachToSubsec(po);     // relink to subsector
 	}
 
+	if (cv_perfstats.value == 6)
+		po->movetime += I_GetPreciseTime() - starttime;
+
 	return !(hitflags & 2);
 }
 
@@ -1403,12 +1567,17 @@ static boolean Polyobj_rotate(polyobj_t *po, angle_t delta, UINT8 turnthings)
 	size_t i;
 	angle_t angle;
 	vector2_t origin;
+	fixed_t newbbox[4];
 	INT32 hitflags = 0;
+	precise_t starttime = 0;
 
 	// don't move bad polyobjects
 	if (po->isBad)
 		return false;
 
+	if (cv_perfstats.value == 6)
+		starttime = I_GetPreciseTime();
+
 	angle = (po->angle + delta) >> ANGLETOFINESHIFT;
 
 	// point about which to rotate is the spawn spot
@@ -1424,6 +1593,15 @@ static boolean Polyobj_rotate(polyobj_t *po, angle_t delta, UINT8 turnthings)
 		*(po->vertices[i]) = po->origVerts[i];
 
 		Polyobj_rotatePoint(po->vertices[i], &origin, angle);
+
+		// grow the new bounding box while the vertex is at hand
+		if (i == 0)
+		{
+			newbbox[BOXLEFT]   = newbbox[BOXRIGHT] = po->vertices[0]->x;
+			newbbox[BOXBOTTOM] = newbbox[BOXTOP]   = po->vertices[0]->y;
+		}
+		else
+			M_AddToBox(newbbox, po->vertices[i]->x, po->vertices[i]->y);
 	}
 
 	// rotate lines
@@ -1431,8 +1609,11 @@ static boolean Polyobj_rotate(polyobj_t *po, angle_t delta, UINT8 turnthings)
 		Polyobj_rotateLine(po->lines[i]);
 
 	// check for blocking things
-	for (i = 0; i < po->numLines; ++i)
-		hitflags |= Polyobj_clipThings(po, po->lines[i]);
+	if (Polyobj_anyThings(po))
+	{
+		for (i = 0; i < po->numLines; ++i)
+			hitflags |= Polyobj_clipThings(po, po->lines[i]);
+	}
 
 	Polyobj_rotateThings(po, origin, delta, turnthings);
 
@@ -1458,12 +1639,16 @@ static boolean Polyobj_rotate(polyobj_t *po, angle_t delta, UINT8 turnthings)
 		// update polyobject's angle
 		po->angle += delta;
 
-		Polyobj_removeFromBlockmap(po); // unlink it from the blockmap
+		memcpy(po->bbox, newbbox, sizeof(newbbox));
+
+		Polyobj_relinkToBlockmap(po);   // relink to blockmap
 		Polyobj_removeFromSubsec(po);   // remove from subsector
-		Polyobj_linkToBlockmap(po);     // relink to blockmap
 		Polyobj_attachToSubsec(po);     // relink to subsector
 	}
 
+	if (cv_perfstats.value == 6)
+		po->movetime += I_GetPreciseTime() - starttime;
+
 	return !(hitflags & 2);
 }
 
@@ -2702,9 +2887,10 @@ void T_PolyObjFlag(polymove_t *th)
 	for (i = 0; i < po->numLines; i++)
 		Polyobj_rotateLine(po->lines[i]);
 
-	Polyobj_removeFromBlockmap(po); // unlink it from the blockmap
+	Polyobj_calcBBox(po);
+
+	Polyobj_relinkToBlockmap(po);   // relink to blockmap
 	Polyobj_removeFromSubsec(po);   // unlink it from its subsector
-	Polyobj_linkToBlockmap(po);     // relink to blockmap
 	Polyobj_attachToSubsec(po);     // relink to subsector
 }
 
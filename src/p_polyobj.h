@@ -87,6 +87,7 @@ typedef struct polyobj_s
 	angle_t angle;         // for rotation
 	UINT8 attached;         // if true, is attached to a subsector
 
+	fixed_t bbox[4];     // bounding box of vertices, kept in sync as it moves
 	fixed_t blockbox[4]; // bounding box for clipping
 	UINT8 linked;         // is linked to blockmap
 	size_t validcount;   // for clipping: prevents multiple checks
@@ -103,6 +104,8 @@ typedef struct polyobj_s
 
 	// these are saved for netgames, so do not let Lua touch these!
 	INT32 spawnflags; // Flags the polyobject originally spawned with
+
+	precise_t movetime; // time spent moving this tic, for perfstats
 } polyobj_t;
 
 //
@@ -129,7 +129,6 @@ INT32 *blockmaplump; // Big blockmap
 fixed_t bmaporgx, bmaporgy;
 // for thing chains
 mobj_t **blocklinks;
-precipmobj_t **precipblocklinks;
 
 // REJECT
 // For fast sight rejection.
@@ -736,8 +735,6 @@ static void P_LoadRawSectors(UINT8 *data)
 		ss->thinglist = NULL;
 		ss->touching_thinglist = NULL;
 
-		ss->touching_preciplist = NULL;
-
 		ss->floordata = NULL;
 		ss->ceilingdata = NULL;
 		ss->lightingdata = NULL;
@@ -1722,9 +1719,6 @@ static void P_CreateBlockMap(void)
 		// haleyjd 2/22/06: setup polyobject blockmap
 		count = sizeof(*polyblocklinks) * bmapwidth * bmapheight;
 		polyblocklinks = Z_Calloc(count, PU_LEVEL, NULL);
-
-		count = sizeof (*precipblocklinks)* bmapwidth*bmapheight;
-		precipblocklinks = Z_Calloc(count, PU_LEVEL, NULL);
 	}
 }
 
@@ -1781,9 +1775,6 @@ static boolean P_LoadRawBlockMap(UINT8 *data, size_t count)
 	count = sizeof(*polyblocklinks) * bmapwidth * bmapheight;
 	polyblocklinks = Z_Calloc(count, PU_LEVEL, NULL);
 
-	count = sizeof (*precipblocklinks)* bmapwidth*bmapheight;
-	precipblocklinks = Z_Calloc(count, PU_LEVEL, NULL);
-
 	return true;
 }
 
@@ -2739,9 +2730,6 @@ boolean P_SetupLevel(boolean skipprecip, boolean reloadinggamestate)
 		Z_Free(ss->attachedsolid);
 	}
 
-	// Clear pointers that would be left dangling by the purge
-	R_FlushTranslationColormapCache();
-
 	Z_FreeTags(PU_LEVEL, PU_PURGELEVEL - 1);
 
 #if defined (WALLSPLATS) || defined (FLOORSPLATS)
@@ -2812,7 +2800,7 @@ boolean P_SetupLevel(boolean skipprecip, boolean reloadinggamestate)
 	P_SpawnSpecials(fromnetsave, reloadinggamestate);
 
 	if (loadprecip) //  ugly hack for P_NetUnArchiveMisc (and P_LoadNetGame)
-		P_SpawnPrecipitation();
+		P_ResetPrecipitation();
 
 #ifdef HWRENDER // not win32 only 19990829 by Kin
 	if (rendermode == render_opengl)
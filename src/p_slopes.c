@@ -22,6 +22,7 @@
 #include "r_main.h"
 #include "p_maputl.h"
 #include "w_wad.h"
+#include "m_perfstats.h" // ps_dynslopes_updated
 
 
 static pslope_t *slopelist = NULL;
@@ -144,6 +145,70 @@ static void P_ReconfigureVertexSlope(pslope_t *slope)
 	P_UpdateSlopeLightOffset(slope);
 }
 
+// Resolve the plane heights a dynamic slope depends on
+static void P_SubscribeSlopeSources(pslope_t *slope)
+{
+	line_t *line = slope->sourceline;
+	size_t i;
+
+	slope->numsources = 0;
+
+	switch (slope->refpos)
+	{
+	case 1: // front floor
+	case 3: // back floor
+		slope->sources[slope->numsources++] = &line->frontsector->floorheight;
+		slope->sources[slope->numsources++] = &line->backsector->floorheight;
+		break;
+	case 2: // front ceiling
+	case 4: // back ceiling
+		slope->sources[slope->numsources++] = &line->frontsector->ceilingheight;
+		slope->sources[slope->numsources++] = &line->backsector->ceilingheight;
+		break;
+	case 5: // vertices
+		for (i = 0; i < 3; i++)
+		{
+			INT32 l = P_FindSpecialLineFromTag(799, slope->vertices[i]->angle, -1);
+			if (l != -1)
+				slope->sources[slope->numsources++] = &lines[l].frontsector->floorheight;
+		}
+		break;
+	default:
+		I_Error("P_RunDynamicSlopes: slope has invalid type!");
+	}
+
+	for (i = 0; i < slope->numsources; i++)
+		slope->sourcecache[i] = *slope->sources[i];
+
+	slope->subscribed = true;
+}
+
+// Returns true if any plane the slope is built from moved since the last check
+static boolean P_SlopeSourcesChanged(pslope_t *slope)
+{
+	boolean changed = false;
+	size_t i;
+
+	if (!slope->subscribed)
+	{
+		// Always recalculate once, so vertex heights and
+		// loaded savegame states get applied.
+		P_SubscribeSlopeSources(slope);
+		return true;
+	}
+
+	for (i = 0; i < slope->numsources; i++)
+	{
+		if (*slope->sources[i] != slope->sourcecache[i])
+		{
+			slope->sourcecache[i] = *slope->sources[i];
+			changed = true;
+		}
+	}
+
+	return changed;
+}
+
 // Recalculate dynamic slopes
 void P_RunDynamicSlopes(void)
 {
@@ -155,6 +220,11 @@ void P_RunDynamicSlopes(void)
 		if (slope->flags & SL_NODYNAMIC)
 			continue;
 
+		if (!P_SlopeSourcesChanged(slope))
+			continue;
+
+		ps_dynslopes_updated.value.i++;
+
 		switch(slope->refpos) {
 		case 1: // front floor
 			zdelta = slope->sourceline->backsector->floorheight - slope->sourceline->frontsector->floorheight;
@@ -68,10 +68,9 @@ void Command_Numthinkers_f(void)
 		CONS_Printf(M_GetText("numthinkers <#>: Count number of thinkers\n"));
 		CONS_Printf(
 			"\t1: P_MobjThinker\n"
-			"\t2: P_NullPrecipThinker\n"
-			"\t3: T_Friction\n"
-			"\t4: T_Pusher\n"
-			"\t5: P_RemoveThinkerDelayed\n");
+			"\t2: T_Friction\n"
+			"\t3: T_Pusher\n"
+			"\t4: P_RemoveThinkerDelayed\n");
 		return;
 	}
 
@@ -84,18 +83,14 @@ void Command_Numthinkers_f(void)
 			CONS_Printf(M_GetText("Number of %s: "), "P_MobjThinker");
 			break;
 		case 2:
-			action = (actionf_p1)P_NullPrecipThinker;
-			CONS_Printf(M_GetText("Number of %s: "), "P_NullPrecipThinker");
-			break;
-		case 3:
 			action = (actionf_p1)T_Friction;
 			CONS_Printf(M_GetText("Number of %s: "), "T_Friction");
 			break;
-		case 4:
+		case 3:
 			action = (actionf_p1)T_Pusher;
 			CONS_Printf(M_GetText("Number of %s: "), "T_Pusher");
 			break;
-		case 5:
+		case 4:
 			action = (actionf_p1)P_RemoveThinkerDelayed;
 			CONS_Printf(M_GetText("Number of %s: "), "P_RemoveThinkerDelayed");
 			break;
@@ -182,6 +177,8 @@ void P_InitThinkers(void)
 {
 	thinkercap.prev = thinkercap.next = &thinkercap;
 	waypointcap = NULL;
+	K_ClearCheckpointWaypoints();
+	K_ClearJawzTargets();
 }
 
 //
@@ -318,8 +315,6 @@ static inline void P_RunThinkers(void)
 {
 	for (currentthinker = thinkercap.next; currentthinker != &thinkercap; currentthinker = currentthinker->next)
 	{
-		if (currentthinker->function.acp1 == (actionf_p1)P_NullPrecipThinker)
-			continue;
 #ifdef PARANOIA
 		I_Assert(currentthinker->function.acp1 != NULL)
 #endif
@@ -515,6 +510,7 @@ void P_Ticker(boolean run)
 		
 		ps_lua_mobjhooks.value.i = 0;
 		ps_checkposition_calls.value.i = 0;
+		ps_dynslopes_updated.value.i = 0;
 
 		PS_START_TIMING(ps_lua_prethinkframe_time);
 		LUAh_PreThinkFrame();
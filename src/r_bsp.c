@@ -15,6 +15,7 @@
 #include "g_game.h"
 #include "r_local.h"
 #include "r_state.h"
+#include "r_fps.h"
 #include "r_portal.h" // Add seg portals
 
 
@@ -500,6 +501,9 @@ static void R_AddLine(seg_t *line)
 	if (!backsector)
 		goto clipsolid;
 
+	R_MarkInterpolatedSector(backsector);
+	if (skyboxrecording)
+		R_RecordSkyboxSector(backsector);
 	backsector = R_FakeFlat(backsector, &tempsec, NULL, NULL, true);
 
 	doorclosed = 0;
@@ -868,6 +872,10 @@ static void R_Subsector(size_t num)
 	sub = &subsectors[num];
 	frontsector = sub->sector;
 	count = sub->numlines;
+
+	R_MarkInterpolatedSector(frontsector);
+	if (skyboxrecording)
+		R_RecordSkyboxSector(frontsector);
 	line = &segs[sub->firstline];
 
 	// Deep water/fake ceiling effect.
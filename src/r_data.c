@@ -26,6 +26,10 @@
 #include "v_video.h" // pLocalPalette
 #include "dehacked.h"
 
+#ifdef HAVE_THREADS
+#include "i_threads.h"
+#endif
+
 #ifdef HWRENDER
 #include "hardware/hw_main.h"
 #include "hardware/hw_glob.h" // HWR_ClearLightTables
@@ -180,108 +184,230 @@ static inline void R_DrawColumnInCache(column_t *patch, UINT8 *cache, INT32 orig
 }
 
 //
-// R_GenerateTexture
-//
-// Allocate space for full size texture, either single patch or 'composite'
-// Build the full textures from patches.
-// The texture caching system is a little more hungry of memory, but has
-// been simplified for the sake of highcolor, dynamic ligthing, & speed.
+// Composite cache
 //
-// This is not optimised, but it's supposed to be executed only once
-// per level, when enough memory is available.
+// Composites stay cached between levels, up to cv_texturecachesize megabytes.
+// Past that, the least recently used ones are freed to make room, but never
+// one used in the current frame, as its columns may still be drawn from.
+// Textures are moved to the front of the LRU list the first time they are used
+// in a frame, so R_GetColumn only pays for a compare the rest of the time.
 //
-static UINT8 *R_GenerateTexture(size_t texnum)
+typedef struct
 {
-	UINT8 *block;
-	UINT8 *blocktex;
-	texture_t *texture;
-	texpatch_t *patch;
-	patch_t *realpatch;
-	int x, x1, x2, i;
-	size_t blocksize;
-	column_t *patchcol;
-	UINT8 *colofs;
+	size_t size; // bytes of the cached composite, 0 when not cached
+	size_t lastused; // framecount of the last frame that used it
+	INT32 prev, next; // LRU list, most recently used first
+	UINT32 hits, misses; // frames it was found cached in, and times it got generated
+} texturecacheinfo_t;
 
-	I_Assert(texnum <= (size_t)numtextures);
-	texture = textures[texnum];
-	I_Assert(texture != NULL);
+static texturecacheinfo_t *texturecacheinfo;
+static INT32 texturelruhead = -1, texturelrutail = -1;
+static size_t texturecachebytes;
 
-	// allocate texture column offset lookup
+static void R_UnlinkTextureCache(INT32 tex)
+{
+	texturecacheinfo_t *info = &texturecacheinfo[tex];
 
-	// single-patch textures can have holes in them and may be used on
-	// 2sided lines so they need to be kept in 'packed' format
-	// BUT this is wrong for skies and walls with over 255 pixels,
-	// so check if there's holes and if not strip the posts.
-	if (texture->patchcount == 1)
+	if (info->prev != -1)
+		texturecacheinfo[info->prev].next = info->next;
+	else
+		texturelruhead = info->next;
+
+	if (info->next != -1)
+		texturecacheinfo[info->next].prev = info->prev;
+	else
+		texturelrutail = info->prev;
+}
+
+static void R_LinkTextureCache(INT32 tex)
+{
+	texturecacheinfo_t *info = &texturecacheinfo[tex];
+
+	info->prev = -1;
+	info->next = texturelruhead;
+
+	if (texturelruhead != -1)
+		texturecacheinfo[texturelruhead].prev = tex;
+	else
+		texturelrutail = tex;
+
+	texturelruhead = tex;
+}
+
+static void R_TouchTexture(INT32 tex)
+{
+	texturecacheinfo[tex].lastused = framecount;
+	texturecacheinfo[tex].hits++;
+
+	if (texturelruhead != tex)
 	{
-		boolean holey = false;
-		patch = texture->patches;
-		realpatch = W_CacheLumpNumPwad(patch->wad, patch->lump, PU_CACHE);
-
-		// Check the patch for holes.
-		if (texture->width > SHORT(realpatch->width) || texture->height > SHORT(realpatch->height))
-			holey = true;
-		colofs = (UINT8 *)realpatch->columnofs;
-		for (x = 0; x < texture->width && !holey; x++)
-		{
-			column_t *col = (column_t *)((UINT8 *)realpatch + LONG(*(UINT32 *)&colofs[x<<2]));
-			INT32 topdelta, prevdelta = -1, y = 0;
-			while (col->topdelta != 0xff)
-			{
-				topdelta = col->topdelta;
-				if (topdelta <= prevdelta)
-					topdelta += prevdelta;
-				prevdelta = topdelta;
-				if (topdelta > y)
-					break;
-				y = topdelta + col->length + 1;
-				col = (column_t *)((UINT8 *)col + col->length + 4);
-			}
-			if (y < texture->height)
-				holey = true; // this texture is HOLEy! D:
-		}
+		R_UnlinkTextureCache(tex);
+		R_LinkTextureCache(tex);
+	}
+}
 
-		// If the patch uses transparency, we have to save it this way.
-		if (holey)
+static void R_AddTextureCache(INT32 tex, size_t size)
+{
+	texturecacheinfo[tex].size = size;
+	texturecacheinfo[tex].lastused = framecount;
+	texturecacheinfo[tex].misses++;
+	texturecachebytes += size;
+	R_LinkTextureCache(tex);
+}
+
+static void R_EvictTexture(INT32 tex)
+{
+	R_UnlinkTextureCache(tex);
+	texturecachebytes -= texturecacheinfo[tex].size;
+	texturecacheinfo[tex].size = 0;
+	Z_Free(texturecache[tex]); // clears texturecache[tex]
+}
+
+static inline size_t R_TextureCacheBudget(void)
+{
+	return (size_t)cv_texturecachesize.value << 20;
+}
+
+// Frees the least recently used composites until needed more bytes fit
+static void R_EvictTextures(size_t needed)
+{
+	const size_t budget = R_TextureCacheBudget();
+
+	while (texturecachebytes + needed > budget
+		&& texturelrutail != -1
+		&& texturecacheinfo[texturelrutail].lastused != framecount)
+	{
+		R_EvictTexture(texturelrutail);
+	}
+}
+
+void R_TrimTextureCache(void)
+{
+	if (texturecacheinfo)
+		R_EvictTextures(0);
+}
+
+static void R_ResetTextureCache(void)
+{
+	texturelruhead = texturelrutail = -1;
+	texturecachebytes = 0;
+}
+
+//
+// R_CheckTextureHoles
+//
+// Single-patch textures can have holes in them and may be used on
+// 2sided lines so they need to be kept in 'packed' format
+// BUT this is wrong for skies and walls with over 255 pixels,
+// so check if there's holes and if not strip the posts.
+//
+static boolean R_CheckTextureHoles(texture_t *texture, patch_t *realpatch)
+{
+	UINT8 *colofs = (UINT8 *)realpatch->columnofs;
+	int x;
+
+	if (texture->width > SHORT(realpatch->width) || texture->height > SHORT(realpatch->height))
+		return true;
+
+	for (x = 0; x < texture->width; x++)
+	{
+		column_t *col = (column_t *)((UINT8 *)realpatch + LONG(*(UINT32 *)&colofs[x<<2]));
+		INT32 topdelta, prevdelta = -1, y = 0;
+		while (col->topdelta != 0xff)
 		{
-			texture->holes = true;
-			blocksize = W_LumpLengthPwad(patch->wad, patch->lump);
-			block = Z_Calloc(blocksize, PU_STATIC, // will change tag at end of this function
-				&texturecache[texnum]);
-			M_Memcpy(block, realpatch, blocksize);
-			texturememory += blocksize;
-
-			// use the patch's column lookup
-			colofs = (block + 8);
-			texturecolumnofs[texnum] = (UINT32 *)colofs;
-			blocktex = block;
-			for (x = 0; x < texture->width; x++)
-				*(UINT32 *)&colofs[x<<2] = LONG(LONG(*(UINT32 *)&colofs[x<<2]) + 3);
-			goto done;
+			topdelta = col->topdelta;
+			if (topdelta <= prevdelta)
+				topdelta += prevdelta;
+			prevdelta = topdelta;
+			if (topdelta > y)
+				break;
+			y = topdelta + col->length + 1;
+			col = (column_t *)((UINT8 *)col + col->length + 4);
 		}
-
-		// Otherwise, do multipatch format.
+		if (y < texture->height)
+			return true; // this texture is HOLEy! D:
 	}
 
-	// multi-patch textures (or 'composite')
+	return false;
+}
+
+// Caches a holey single-patch texture as a copy of its patch
+static UINT8 *R_CacheHoleyTexture(size_t texnum, patch_t *realpatch)
+{
+	texture_t *texture = textures[texnum];
+	texpatch_t *patch = texture->patches;
+	size_t blocksize = W_LumpLengthPwad(patch->wad, patch->lump);
+	UINT8 *block, *colofs;
+	int x;
+
+	texture->holes = true;
+	R_EvictTextures(blocksize);
+	block = Z_Calloc(blocksize, PU_STATIC, // will change tag at end of this function
+		&texturecache[texnum]);
+	M_Memcpy(block, realpatch, blocksize);
+	texturememory += blocksize;
+	R_AddTextureCache(texnum, blocksize);
+
+	// use the patch's column lookup
+	colofs = (block + 8);
+	texturecolumnofs[texnum] = (UINT32 *)colofs;
+	for (x = 0; x < texture->width; x++)
+		*(UINT32 *)&colofs[x<<2] = LONG(LONG(*(UINT32 *)&colofs[x<<2]) + 3);
+
+	// Now that the texture has been built in column cache, it is purgable from zone memory.
+	Z_ChangeTag(block, PU_CACHE);
+	return block;
+}
+
+static inline size_t R_CompositeSize(texture_t *texture)
+{
+	return (texture->width * 4) + (texture->width * texture->height);
+}
+
+// Allocates a composite texture and its columns lookup table
+static UINT8 *R_AllocComposite(size_t texnum)
+{
+	texture_t *texture = textures[texnum];
+	size_t blocksize = R_CompositeSize(texture);
+	UINT8 *block;
+	int x;
+
 	texture->holes = false;
-	blocksize = (texture->width * 4) + (texture->width * texture->height);
+	R_EvictTextures(blocksize);
 	texturememory += blocksize;
 	block = Z_Malloc(blocksize+1, PU_STATIC, &texturecache[texnum]);
+	R_AddTextureCache(texnum, blocksize);
 
 	memset(block, 0xF7, blocksize+1); // Transparency hack
 
-	// columns lookup table
-	colofs = block;
-	texturecolumnofs[texnum] = (UINT32 *)colofs;
+	// columns lookup table, the texture data comes after it
+	texturecolumnofs[texnum] = (UINT32 *)block;
+	for (x = 0; x < texture->width; x++)
+		*(UINT32 *)&block[x<<2] = LONG((x * texture->height) + (texture->width*4));
 
-	// texture data after the lookup table
-	blocktex = block + (texture->width*4);
+	return block;
+}
+
+//
+// R_CompositeTexture
+//
+// Composites the columns of the patches together.
+// Touches nothing but the block, so it can run on any thread
+// when given the already cached realpatches.
+//
+static void R_CompositeTexture(texture_t *texture, UINT8 *block, patch_t **realpatches)
+{
+	texpatch_t *patch;
+	patch_t *realpatch;
+	column_t *patchcol;
+	int x, x1, x2, i;
 
-	// Composite the columns together.
 	for (i = 0, patch = texture->patches; i < texture->patchcount; i++, patch++)
 	{
-		realpatch = W_CacheLumpNumPwad(patch->wad, patch->lump, PU_CACHE);
+		if (realpatches)
+			realpatch = realpatches[i];
+		else
+			realpatch = W_CacheLumpNumPwad(patch->wad, patch->lump, PU_CACHE);
 		x1 = patch->originx;
 		x2 = x1 + SHORT(realpatch->width);
 
@@ -296,19 +422,192 @@ static UINT8 *R_GenerateTexture(size_t texnum)
 		for (; x < x2; x++)
 		{
 			patchcol = (column_t *)((UINT8 *)realpatch + LONG(realpatch->columnofs[x-x1]));
-
-			// generate column ofset lookup
-			*(UINT32 *)&colofs[x<<2] = LONG((x * texture->height) + (texture->width*4));
-			R_DrawColumnInCache(patchcol, block + LONG(*(UINT32 *)&colofs[x<<2]), patch->originy, texture->height);
+			R_DrawColumnInCache(patchcol, block + LONG(*(UINT32 *)&block[x<<2]), patch->originy, texture->height);
 		}
 	}
+}
+
+//
+// R_GenerateTexture
+//
+// Allocate space for full size texture, either single patch or 'composite'
+// Build the full textures from patches.
+// The texture caching system is a little more hungry of memory, but has
+// been simplified for the sake of highcolor, dynamic ligthing, & speed.
+//
+// This is not optimised, but it's supposed to be executed only once
+// per level, when enough memory is available.
+//
+static UINT8 *R_GenerateTexture(size_t texnum)
+{
+	UINT8 *block;
+	texture_t *texture;
+
+	I_Assert(texnum <= (size_t)numtextures);
+	texture = textures[texnum];
+	I_Assert(texture != NULL);
+
+	if (texture->patchcount == 1)
+	{
+		texpatch_t *patch = texture->patches;
+		patch_t *realpatch = W_CacheLumpNumPwad(patch->wad, patch->lump, PU_CACHE);
+
+		// If the patch uses transparency, we have to save it this way.
+		if (R_CheckTextureHoles(texture, realpatch))
+			return R_CacheHoleyTexture(texnum, realpatch);
+
+		// Otherwise, do multipatch format.
+	}
+
+	// multi-patch textures (or 'composite')
+	block = R_AllocComposite(texnum);
+	R_CompositeTexture(texture, block, NULL);
 
-done:
 	// Now that the texture has been built in column cache, it is purgable from zone memory.
 	Z_ChangeTag(block, PU_CACHE);
-	return blocktex;
+	return block;
+}
+
+#ifdef HAVE_THREADS
+//
+// Threaded compositing
+//
+// R_PrecacheLevel allocates the composites of the level and caches their
+// patches on the main thread, since neither the zone nor the WAD code can
+// be used from other threads. The columns then get composited by up to
+// cv_renderthreads threads, each taking the next texture off the list.
+//
+typedef struct
+{
+	texture_t *texture;
+	UINT8 *block;
+	size_t firstpatch; // in compositepatches
+} compositejob_t;
+
+static compositejob_t *compositejobs;
+static size_t numcompositejobs, maxcompositejobs;
+static patch_t **compositepatches;
+static size_t numcompositepatches, maxcompositepatches;
+
+static I_mutex composite_mutex;
+static I_cond composite_cond; // R_CompositeTextures waits here for the last job
+static size_t nextcompositejob, donecompositejobs;
+
+static void R_RunCompositeJobs(void)
+{
+	compositejob_t *job;
+
+	for (;;)
+	{
+		I_lock_mutex(&composite_mutex);
+		if (nextcompositejob >= numcompositejobs)
+		{
+			I_unlock_mutex(composite_mutex);
+			return;
+		}
+		job = &compositejobs[nextcompositejob++];
+		I_unlock_mutex(composite_mutex);
+
+		R_CompositeTexture(job->texture, job->block, &compositepatches[job->firstpatch]);
+
+		I_lock_mutex(&composite_mutex);
+		if (++donecompositejobs == numcompositejobs)
+			I_wake_all_cond(&composite_cond);
+		I_unlock_mutex(composite_mutex);
+	}
+}
+
+static void R_CompositeThread(void *userdata)
+{
+	(void)userdata;
+	R_RunCompositeJobs();
+}
+
+static void R_QueueComposite(size_t texnum)
+{
+	texture_t *texture = textures[texnum];
+	compositejob_t *job;
+	texpatch_t *patch;
+	INT32 i;
+
+	if (numcompositejobs >= maxcompositejobs)
+	{
+		maxcompositejobs = maxcompositejobs ? maxcompositejobs*2 : 256;
+		compositejobs = Z_Realloc(compositejobs, maxcompositejobs * sizeof (*compositejobs), PU_STATIC, NULL);
+	}
+
+	while (numcompositepatches + texture->patchcount > maxcompositepatches)
+	{
+		maxcompositepatches = maxcompositepatches ? maxcompositepatches*2 : 1024;
+		compositepatches = Z_Realloc(compositepatches, maxcompositepatches * sizeof (*compositepatches), PU_STATIC, NULL);
+	}
+
+	job = &compositejobs[numcompositejobs++];
+	job->texture = texture;
+	job->block = R_AllocComposite(texnum);
+	job->firstpatch = numcompositepatches;
+
+	for (i = 0, patch = texture->patches; i < texture->patchcount; i++, patch++)
+		compositepatches[numcompositepatches++] = W_CacheLumpNumPwad(patch->wad, patch->lump, PU_CACHE);
 }
 
+// Generates every texture set in texturepresent that fits in the cache
+static void R_CompositeTextures(const char *texturepresent)
+{
+	const size_t budget = R_TextureCacheBudget();
+	size_t j, numthreads;
+
+	I_lock_mutex(&composite_mutex);
+	numcompositejobs = numcompositepatches = 0;
+	nextcompositejob = donecompositejobs = 0;
+
+	for (j = 0; j < (unsigned)numtextures; j++)
+	{
+		texture_t *texture = textures[j];
+
+		if (!texturepresent[j] || texturecache[j])
+			continue;
+
+		if (texture->patchcount == 1)
+		{
+			texpatch_t *patch = texture->patches;
+			patch_t *realpatch = W_CacheLumpNumPwad(patch->wad, patch->lump, PU_CACHE);
+
+			if (R_CheckTextureHoles(texture, realpatch))
+			{
+				R_CacheHoleyTexture(j, realpatch);
+				continue;
+			}
+		}
+
+		// Leave the rest to R_GetColumn, rather than evicting this level's own textures
+		R_EvictTextures(R_CompositeSize(texture));
+		if (texturecachebytes + R_CompositeSize(texture) > budget)
+			continue;
+
+		R_QueueComposite(j);
+	}
+	I_unlock_mutex(composite_mutex);
+
+	if (!numcompositejobs)
+		return;
+
+	numthreads = min((size_t)cv_renderthreads.value, numcompositejobs);
+	for (j = 1; j < numthreads; j++)
+		I_spawn_thread("texture-compositor", R_CompositeThread, NULL);
+
+	R_RunCompositeJobs();
+
+	I_lock_mutex(&composite_mutex);
+	while (donecompositejobs < numcompositejobs)
+		I_hold_cond(&composite_cond, composite_mutex);
+
+	// Threads only just getting started now find nothing left to do
+	numcompositejobs = 0;
+	I_unlock_mutex(composite_mutex);
+}
+#endif
+
 //
 // R_GetTextureNum
 //
@@ -333,6 +632,8 @@ void R_CheckTextureCache(INT32 tex)
 {
 	if (!texturecache[tex])
 		R_GenerateTexture(tex);
+	else if (texturecacheinfo[tex].lastused != framecount)
+		R_TouchTexture(tex);
 }
 
 //
@@ -347,6 +648,8 @@ UINT8 *R_GetColumn(fixed_t tex, INT32 col)
 
 	if (!data)
 		data = R_GenerateTexture(tex);
+	else if (texturecacheinfo[tex].lastused != framecount)
+		R_TouchTexture(tex);
 
 	return data + LONG(texturecolumnofs[tex][col]);
 }
@@ -367,7 +670,41 @@ void R_FlushTextureCache(void)
 
 	if (numtextures)
 		for (i = 0; i < numtextures; i++)
+		{
 			Z_Free(texturecache[i]);
+			texturecacheinfo[i].size = 0;
+		}
+
+	R_ResetTextureCache();
+}
+
+//
+// Lists the composites generated more than once, and how the cache is doing
+//
+void R_TextureCacheStats_f(void)
+{
+	UINT32 hits = 0, misses = 0;
+	INT32 i, cached = 0;
+
+	if (!numtextures)
+		return;
+
+	for (i = 0; i < numtextures; i++)
+	{
+		const texturecacheinfo_t *info = &texturecacheinfo[i];
+
+		hits += info->hits;
+		misses += info->misses;
+		if (info->size)
+			cached++;
+
+		if (info->misses > 1)
+			CONS_Printf("%.8s: %u hits, %u misses\n", textures[i]->name, info->hits, info->misses);
+	}
+
+	CONS_Printf("%d textures cached, %s k of %s k\n", cached,
+		sizeu1(texturecachebytes>>10), sizeu2(R_TextureCacheBudget()>>10));
+	CONS_Printf("%u hits, %u misses\n", hits, misses);
 }
 
 // Need these prototypes for later; defining them here instead of r_data.h so they're "private"
@@ -399,6 +736,8 @@ void R_LoadTextures(void)
 		}
 		Z_Free(texturetranslation);
 		Z_Free(textures);
+		Z_Free(texturecacheinfo);
+		R_ResetTextureCache();
 	}
 
 	// Load patches and textures.
@@ -471,6 +810,9 @@ void R_LoadTextures(void)
 	for (i = 0; i < numtextures; i++)
 		texturetranslation[i] = i;
 
+	// Composite cache bookkeeping, see R_EvictTextures
+	texturecacheinfo = Z_Calloc(numtextures * sizeof (*texturecacheinfo), PU_STATIC, NULL);
+
 	for (i = 0, w = 0; w < numwadfiles; w++)
 	{
 		// Get the lump numbers for the markers in the WAD, if they exist.
@@ -1667,6 +2009,9 @@ void R_PrecacheLevel(void)
 	texturepresent[skytexture] = 1;
 
 	texturememory = 0;
+#ifdef HAVE_THREADS
+	R_CompositeTextures(texturepresent);
+#else
 	for (j = 0; j < (unsigned)numtextures; j++)
 	{
 		if (!texturepresent[j])
@@ -1677,6 +2022,7 @@ void R_PrecacheLevel(void)
 		// pre-caching individual patches that compose textures became obsolete,
 		// since we cache entire composite textures
 	}
+#endif
 	free(texturepresent);
 
 	//
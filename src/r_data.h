@@ -64,6 +64,8 @@ extern CV_PossibleValue_t Color_cons_t[];
 // Load TEXTURE1/TEXTURE2/PNAMES definitions, create lookup tables
 void R_LoadTextures(void);
 void R_FlushTextureCache(void);
+void R_TrimTextureCache(void);
+void R_TextureCacheStats_f(void);
 
 INT32 R_GetTextureNum(INT32 texnum);
 void R_CheckTextureCache(INT32 tex);
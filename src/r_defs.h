@@ -255,6 +255,12 @@ typedef struct pslope_s
 	UINT8 flags; // Slope options
 	mapthing_t **vertices; // List should be three long for slopes made by vertex things, or one long for slopes using one vertex thing to anchor
 
+	// Dynamic slope dirty tracking (see P_RunDynamicSlopes)
+	boolean subscribed; // Source planes below have been resolved
+	UINT8 numsources;
+	fixed_t *sources[3]; // Plane heights this slope is built from
+	fixed_t sourcecache[3]; // Values of the above when the slope was last recalculated
+
 	struct pslope_s *next; // Make a linked list of dynamic slopes, for easy reference later
 
 	// Light offsets (see seg_t)
@@ -339,6 +345,7 @@ typedef struct sector_s
 	lightlist_t *lightlist;
 	INT32 numlights;
 	boolean moved;
+	UINT32 interpframe; // last frame the renderer reached this sector (see R_MarkInterpolatedSector)
 
 	// per-sector colormaps!
 	extracolormap_t *extra_colormap;
@@ -354,9 +361,6 @@ typedef struct sector_s
 	// Current speed of ceiling/floor. For Knuckles to hold onto stuff.
 	fixed_t floorspeed, ceilspeed;
 
-	// list of precipitation mobjs in sector
-	struct mprecipsecnode_s *touching_preciplist;
-
 	// Eternity engine slope
 	pslope_t *f_slope; // floor slope
 	pslope_t *c_slope; // ceiling slope
@@ -492,17 +496,6 @@ typedef struct msecnode_s
 	boolean visited; // used in search algorithms
 } msecnode_t;
 
-typedef struct mprecipsecnode_s
-{
-	sector_t *m_sector; // a sector containing this object
-	struct precipmobj_s *m_thing;  // this object
-	struct mprecipsecnode_s *m_sectorlist_prev;  // prev msecnode_t for this thing
-	struct mprecipsecnode_s *m_sectorlist_next;  // next msecnode_t for this thing
-	struct mprecipsecnode_s *m_thinglist_prev;  // prev msecnode_t for this sector
-	struct mprecipsecnode_s *m_thinglist_next;  // next msecnode_t for this sector
-	boolean visited; // used in search algorithms
-} mprecipsecnode_t;
-
 //
 // The lineseg.
 //
@@ -636,10 +629,20 @@ typedef enum
 
 // rotsprite
 #ifdef ROTSPRITE
+// Bookkeeping for one cached rotation, see RotatedPatch_Trim
+typedef struct rotspriteslot_s
+{
+	struct rotspriteslot_s *prev, *next; // LRU list, most recently used first
+	void **patch; // in rotsprite_t patches, NULL when not on the list
+	size_t size;
+	size_t lastused; // framecount of the last frame that used it
+} rotspriteslot_t;
+
 typedef struct
 {
 	INT32 angles;
 	void **patches;
+	rotspriteslot_t *slots; // one per patch
 } rotsprite_t;
 #endif
 
@@ -27,11 +27,24 @@
 #include "z_zone.h"
 #include "console.h" // Until buffering gets finished
 #include "k_kart.h" // SRB2kart
+#include "m_random.h" // drawer benchmark spans
+#include "i_system.h" // I_GetPreciseTime
 
 #ifdef HWRENDER
 #include "hardware/hw_main.h"
 #endif
 
+#ifdef VECTORDRAWERS
+#ifdef __ARM_NEON
+#include <arm_neon.h>
+#else
+#include <emmintrin.h>
+#endif
+#ifdef VECTORDRAWERS_AVX2
+#include <immintrin.h>
+#endif
+#endif
+
 // ==========================================================================
 //                     COMMON DATA FOR 8bpp AND 16bpp
 // ==========================================================================
@@ -107,12 +120,12 @@ INT32 dc_numlights = 0, dc_maxlights, dc_texheight;
 //                      SPAN DRAWING CODE STUFF
 // =========================================================================
 
-INT32 ds_y, ds_x1, ds_x2;
-lighttable_t *ds_colormap;
-fixed_t ds_xfrac, ds_yfrac, ds_xstep, ds_ystep;
+THREADLOCAL INT32 ds_y, ds_x1, ds_x2;
+THREADLOCAL lighttable_t *ds_colormap;
+THREADLOCAL fixed_t ds_xfrac, ds_yfrac, ds_xstep, ds_ystep;
 
-UINT8 *ds_source; // points to the start of a flat
-UINT8 *ds_transmap; // one of the translucency tables
+THREADLOCAL UINT8 *ds_source; // points to the start of a flat
+THREADLOCAL UINT8 *ds_transmap; // one of the translucency tables
 
 // Vectors for Software's tilted slope drawers
 floatv3_t *ds_su, *ds_sv, *ds_sz;
@@ -122,7 +135,7 @@ float focallengthf, zeroheight;
 /**	\brief Variable flat sizes
 */
 
-UINT32 nflatxshift, nflatyshift, nflatshiftup, nflatmask;
+THREADLOCAL UINT32 nflatxshift, nflatyshift, nflatshiftup, nflatmask;
 
 // ==========================================================================
 //                        OLD DOOM FUZZY EFFECT
@@ -236,8 +249,26 @@ void R_InitTranslationTables(void)
 	W_ReadLump(W_GetNumForName("TRANS90"), transtables+0x80000);
 }
 
+// Returns the row of translationtablecache for skinnum, TC_DEFAULT, TC_BOSS, etc.
+static INT32 R_SkinTableIndex(INT32 skinnum)
+{
+	switch (skinnum)
+	{
+		case TC_DEFAULT:     return DEFAULT_TT_CACHE_INDEX;
+		case TC_BOSS:        return BOSS_TT_CACHE_INDEX;
+		case TC_METALSONIC:  return METALSONIC_TT_CACHE_INDEX;
+		case TC_ALLWHITE:    return ALLWHITE_TT_CACHE_INDEX;
+		case TC_RAINBOW:     return RAINBOW_TT_CACHE_INDEX;
+		case TC_BLINK:       return BLINK_TT_CACHE_INDEX;
+		default:             return skinnum;
+	}
+}
+
 /**	\brief	Retrieves a translation colormap from the cache.
 
+	Cached colormaps are kept for good, and are only ever regenerated in
+	place by R_UpdateTranslationColormaps, so their pointers stay valid.
+
 	\param	skinnum	number of skin, TC_DEFAULT or TC_BOSS
 	\param	color	translation color
 	\param	flags	set GTC_CACHE to use the cache
@@ -259,13 +290,7 @@ static UINT8* RGetTranslationColormap(INT32 skinnum, skincolors_t color, UINT8 f
 	{
 		tt = translationtablecache;
 		// Adjust if we want the default colormap
-		if (skinnum == TC_DEFAULT) skintableindex = DEFAULT_TT_CACHE_INDEX;
-		else if (skinnum == TC_BOSS) skintableindex = BOSS_TT_CACHE_INDEX;
-		else if (skinnum == TC_METALSONIC) skintableindex = METALSONIC_TT_CACHE_INDEX;
-		else if (skinnum == TC_ALLWHITE) skintableindex = ALLWHITE_TT_CACHE_INDEX;
-		else if (skinnum == TC_RAINBOW) skintableindex = RAINBOW_TT_CACHE_INDEX;
-		else if (skinnum == TC_BLINK) skintableindex = BLINK_TT_CACHE_INDEX;
-		else skintableindex = skinnum;
+		skintableindex = R_SkinTableIndex(skinnum);
 	}
 
 	if (flags & GTC_CACHE)
@@ -283,7 +308,7 @@ static UINT8* RGetTranslationColormap(INT32 skinnum, skincolors_t color, UINT8 f
 	// Generate the colormap if necessary
 	if (!ret)
 	{
-		ret = Z_MallocAlign(NUM_PALETTE_ENTRIES, (flags & GTC_CACHE) ? PU_LEVEL : PU_STATIC, NULL, 8);
+		ret = Z_MallocAlign(NUM_PALETTE_ENTRIES, PU_STATIC, NULL, 8);
 		K_GenerateKartColormap(ret, skinnum, color, local); //R_GenerateTranslationColormap(ret, skinnum, color);		// SRB2kart
 
 		// Cache the colormap if desired
@@ -334,25 +359,28 @@ patch_t* R_GetSkinFaceMini(player_t* ply)
 	return facemmapprefix[ply->skin];
 }
 
-/**	\brief	Flushes cache of translation colormaps.
+/**	\brief	Regenerates the cached translation colormaps of a skin.
+
+	Needed whenever something K_GenerateKartColormap reads changes:
+	the skin itself, or the palette for TC_RAINBOW. The colormaps are
+	rebuilt in place, so nothing drawing with them is left dangling.
 
-	Flushes cache of translation colormaps, but doesn't actually free the
-	colormaps themselves. These are freed when PU_LEVEL blocks are purged,
-	at or before which point, this function should be called.
+	\param	skinnum	number of skin, TC_DEFAULT, TC_RAINBOW, etc.
+	\param	local	skinnum is a local skin
 
 	\return	void
 */
-void R_FlushTranslationColormapCache(void)
+void R_UpdateTranslationColormaps(INT32 skinnum, boolean local)
 {
-	INT32 i;
+	UINT8 **row = local ? localtranslationtablecache[skinnum] : translationtablecache[R_SkinTableIndex(skinnum)];
+	INT32 color;
 
-	for (i = 0; i < (INT32)(sizeof(translationtablecache) / sizeof(translationtablecache[0])); i++)
-		if (translationtablecache[i])
-			memset(translationtablecache[i], 0, MAXTRANSLATIONS * sizeof(UINT8**));
+	if (!row)
+		return;
 
-	for (i = 0; i < (INT32)(sizeof(localtranslationtablecache) / sizeof(localtranslationtablecache[0])); i++)
-		if (localtranslationtablecache[i])
-			memset(localtranslationtablecache[i], 0, MAXTRANSLATIONS * sizeof(UINT8**));
+	for (color = 0; color < MAXTRANSLATIONS; color++)
+		if (row[color])
+			K_GenerateKartColormap(row[color], skinnum, (UINT8)color, local);
 }
 
 /*
@@ -599,3 +627,221 @@ void R_DrawViewBorder(void)
 #ifdef HIGHCOLOR
 #include "r_draw16.c"
 #endif
+
+#ifdef VECTORDRAWERS_AVX2
+/**	\brief	The R_HasAVX2 function
+	Tells whether the CPU, and the OS, can run the AVX2 span drawers.
+*/
+boolean R_HasAVX2(void)
+{
+	static INT32 hasavx2 = -1;
+
+	if (hasavx2 == -1)
+	{
+		__builtin_cpu_init();
+		hasavx2 = __builtin_cpu_supports("avx2") ? 1 : 0;
+	}
+
+	return (hasavx2 == 1);
+}
+#endif
+
+#ifdef VECTORDRAWERS
+// ==========================================================================
+//                            DRAWER BENCHMARK
+// ==========================================================================
+
+#define BENCHSPANS 4096
+
+typedef struct
+{
+	const char *name;
+	void (*scalar)(void);
+	void (*vector)(void);
+	void (*avx2)(void); // NULL where there's no AVX2 version
+} drawerbench_t;
+
+typedef struct
+{
+	INT32 y, x1, x2;
+	fixed_t xfrac, yfrac, xstep, ystep;
+	floatv3_t su, sv, sz; // for the tilted drawers
+} benchspan_t;
+
+static void R_SetBenchSpan(benchspan_t *span)
+{
+	ds_y = span->y;
+	ds_x1 = span->x1;
+	ds_x2 = span->x2;
+	ds_xfrac = span->xfrac;
+	ds_yfrac = span->yfrac;
+	ds_xstep = span->xstep;
+	ds_ystep = span->ystep;
+	ds_sup = &span->su;
+	ds_svp = &span->sv;
+	ds_szp = &span->sz;
+}
+
+static precise_t R_TimeBenchSpans(void (*func)(void), benchspan_t *spans)
+{
+	precise_t start = I_GetPreciseTime();
+	INT32 i;
+
+	for (i = 0; i < BENCHSPANS; i++)
+	{
+		R_SetBenchSpan(&spans[i]);
+		func();
+	}
+
+	return I_GetPreciseTime() - start;
+}
+
+// Draws every span with both drawers over the same saved rows, and counts the spans that came out different.
+static INT32 R_CompareBenchSpans(void (*scalar)(void), void (*vector)(void), benchspan_t *spans, const UINT8 *saved, UINT8 *scalarrow)
+{
+	INT32 i, mismatches = 0;
+	UINT8 *row;
+
+	for (i = 0; i < BENCHSPANS; i++)
+	{
+		R_SetBenchSpan(&spans[i]);
+		row = ylookup[ds_y] + columnofs[0];
+
+		M_Memcpy(row, saved + ds_y*vid.width, viewwidth);
+		scalar();
+		M_Memcpy(scalarrow, row, viewwidth);
+
+		// the scalar tilted drawers move ds_x1 along as they go
+		R_SetBenchSpan(&spans[i]);
+		M_Memcpy(row, saved + ds_y*vid.width, viewwidth);
+		vector();
+
+		if (memcmp(scalarrow, row, viewwidth))
+			mismatches++;
+	}
+
+	return mismatches;
+}
+
+//
+// R_DrawerBench_f
+//
+// Draws the same random spans, flat and tilted, with each vector drawer (and its
+// AVX2 version, if the CPU has it) and the scalar drawer it replaces, checks that
+// every pixel matches, and prints how long each took and how many pixels per
+// microsecond that comes to.
+//
+void R_DrawerBench_f(void)
+{
+	static const drawerbench_t benches[] = {
+#ifdef VECTORDRAWERS_AVX2
+		{"R_DrawSpan_8",            R_DrawSpan_8,            R_DrawSpan_8_Vector,            R_DrawSpan_8_AVX2},
+		{"R_DrawTranslucentSpan_8", R_DrawTranslucentSpan_8, R_DrawTranslucentSpan_8_Vector, R_DrawTranslucentSpan_8_AVX2},
+		{"R_DrawSplat_8",           R_DrawSplat_8,           R_DrawSplat_8_Vector,           R_DrawSplat_8_AVX2},
+#else
+		{"R_DrawSpan_8",            R_DrawSpan_8,            R_DrawSpan_8_Vector,            NULL},
+		{"R_DrawTranslucentSpan_8", R_DrawTranslucentSpan_8, R_DrawTranslucentSpan_8_Vector, NULL},
+		{"R_DrawSplat_8",           R_DrawSplat_8,           R_DrawSplat_8_Vector,           NULL},
+#endif
+		{"R_DrawTiltedSpan_8",      R_DrawTiltedSpan_8,      R_DrawTiltedSpan_8_Vector,      NULL},
+		{"R_DrawTiltedTranslucentSpan_8", R_DrawTiltedTranslucentSpan_8, R_DrawTiltedTranslucentSpan_8_Vector, NULL},
+#ifndef NOWATER
+		{"R_DrawTiltedTranslucentWaterSpan_8", R_DrawTiltedTranslucentWaterSpan_8, R_DrawTiltedTranslucentWaterSpan_8_Vector, NULL},
+#endif
+		{"R_DrawTiltedSplat_8",     R_DrawTiltedSplat_8,     R_DrawTiltedSplat_8_Vector,     NULL},
+	};
+	const UINT64 precision = max(I_GetPrecisePrecision() / 1000000, 1);
+	benchspan_t *spans;
+	UINT8 *flat, *saved, *scalarrow;
+	size_t b;
+	INT32 i, mismatches;
+	precise_t scalartime, vectortime;
+	UINT64 pixels = 0;
+
+	if (rendermode != render_soft || !viewwidth || !viewheight || !screens[1])
+	{
+		CONS_Printf(M_GetText("drawerbench only works in the software renderer.\n"));
+		return;
+	}
+
+	spans = Z_Malloc(BENCHSPANS * sizeof (*spans), PU_STATIC, NULL);
+	flat = Z_Malloc(64*64, PU_STATIC, NULL);
+	saved = Z_Malloc(vid.width * viewheight, PU_STATIC, NULL);
+	scalarrow = Z_Malloc(vid.width, PU_STATIC, NULL);
+
+	for (i = 0; i < 64*64; i++)
+		flat[i] = (UINT8)M_RandomKey(256);
+
+	for (i = 0; i < BENCHSPANS; i++)
+	{
+		spans[i].y = M_RandomKey(viewheight);
+		spans[i].x1 = M_RandomKey(viewwidth);
+		spans[i].x2 = M_RandomRange(spans[i].x1, viewwidth - 1);
+		pixels += spans[i].x2 - spans[i].x1 + 1;
+		spans[i].xfrac = (fixed_t)((UINT32)M_RandomFixed() << M_RandomKey(16));
+		spans[i].yfrac = (fixed_t)((UINT32)M_RandomFixed() << M_RandomKey(16));
+		spans[i].xstep = M_RandomRange(-8*FRACUNIT, 8*FRACUNIT);
+		spans[i].ystep = M_RandomRange(-8*FRACUNIT, 8*FRACUNIT);
+
+		// Keep 1/z finite across the whole view
+		spans[i].sz.x = M_RandomRange(-100, 100) / 1000000.0f;
+		spans[i].sz.y = M_RandomRange(-100, 100) / 1000000.0f;
+		spans[i].sz.z = 0.5f;
+		spans[i].su.x = M_RandomRange(-100000, 100000) * 1.0f;
+		spans[i].su.y = M_RandomRange(-100000, 100000) * 1.0f;
+		spans[i].su.z = M_RandomRange(-100000, 100000) * 1000.0f;
+		spans[i].sv.x = M_RandomRange(-100000, 100000) * 1.0f;
+		spans[i].sv.y = M_RandomRange(-100000, 100000) * 1.0f;
+		spans[i].sv.z = M_RandomRange(-100000, 100000) * 1000.0f;
+	}
+
+	for (i = 0; i < viewheight; i++)
+		M_Memcpy(saved + i*vid.width, ylookup[i] + columnofs[0], viewwidth);
+
+	ds_source = flat;
+	ds_colormap = colormaps;
+	ds_transmap = transtables + ((tr_trans50-1)<<FF_TRANSSHIFT);
+	nflatmask = 0xFC0;
+	nflatxshift = 26;
+	nflatyshift = 20;
+	nflatshiftup = 10;
+	planezlight = scalelight[LIGHTLEVELS/2];
+	ds_bgofs = 0;
+
+	for (b = 0; b < sizeof (benches) / sizeof (benches[0]); b++)
+	{
+		mismatches = R_CompareBenchSpans(benches[b].scalar, benches[b].vector, spans, saved, scalarrow);
+
+		scalartime = R_TimeBenchSpans(benches[b].scalar, spans);
+		vectortime = R_TimeBenchSpans(benches[b].vector, spans);
+
+		scalartime = max(scalartime / precision, 1);
+		vectortime = max(vectortime / precision, 1);
+
+		CONS_Printf("%s: scalar %s us (%s px/us), vector %s us (%s px/us), %s\n", benches[b].name,
+			sizeu1((size_t)scalartime), sizeu2((size_t)(pixels / scalartime)),
+			sizeu3((size_t)vectortime), sizeu4((size_t)(pixels / vectortime)),
+			mismatches ? va("\x85%d spans differ\x80", mismatches) : "\x83identical\x80");
+
+#ifdef VECTORDRAWERS_AVX2
+		if (benches[b].avx2 && R_HasAVX2())
+		{
+			mismatches = R_CompareBenchSpans(benches[b].scalar, benches[b].avx2, spans, saved, scalarrow);
+			vectortime = max(R_TimeBenchSpans(benches[b].avx2, spans) / precision, 1);
+
+			CONS_Printf("%s: AVX2 %s us (%s px/us), %s\n", benches[b].name,
+				sizeu1((size_t)vectortime), sizeu2((size_t)(pixels / vectortime)),
+				mismatches ? va("\x85%d spans differ\x80", mismatches) : "\x83identical\x80");
+		}
+#endif
+	}
+
+	for (i = 0; i < viewheight; i++)
+		M_Memcpy(ylookup[i] + columnofs[0], saved + i*vid.width, viewwidth);
+
+	Z_Free(spans);
+	Z_Free(flat);
+	Z_Free(saved);
+	Z_Free(scalarrow);
+}
+#endif
@@ -57,13 +57,14 @@ extern INT32 dc_texheight;
 // SPAN DRAWING CODE STUFF
 // -----------------------
 
-extern INT32 ds_y, ds_x1, ds_x2;
-extern lighttable_t *ds_colormap;
-extern fixed_t ds_xfrac, ds_yfrac, ds_xstep, ds_ystep;
+// Per thread, so R_DrawPlanes can hand spans to other threads
+extern THREADLOCAL INT32 ds_y, ds_x1, ds_x2;
+extern THREADLOCAL lighttable_t *ds_colormap;
+extern THREADLOCAL fixed_t ds_xfrac, ds_yfrac, ds_xstep, ds_ystep;
 extern INT32 ds_waterofs, ds_bgofs;
-extern UINT8 *ds_source; // start of a 64*64 tile image
+extern THREADLOCAL UINT8 *ds_source; // start of a 64*64 tile image
 extern INT32 dc_sourcelength;
-extern UINT8 *ds_transmap;
+extern THREADLOCAL UINT8 *ds_transmap;
 
 extern INT32 ds_bgofs;
 
@@ -77,10 +78,10 @@ extern floatv3_t *ds_sup, *ds_svp, *ds_szp;
 extern float focallengthf, zeroheight;
 
 // Variable flat sizes
-extern UINT32 nflatxshift;
-extern UINT32 nflatyshift;
-extern UINT32 nflatshiftup;
-extern UINT32 nflatmask;
+extern THREADLOCAL UINT32 nflatxshift;
+extern THREADLOCAL UINT32 nflatyshift;
+extern THREADLOCAL UINT32 nflatshiftup;
+extern THREADLOCAL UINT32 nflatmask;
 
 /// \brief Top border
 #define BRDR_T 0
@@ -123,7 +124,7 @@ UINT8* R_GetLocalTranslationColormap(skin_t *skin, skin_t *localskin, skincolors
 patch_t* R_GetSkinFaceRank(player_t* ply);
 patch_t* R_GetSkinFaceWant(player_t* ply);
 patch_t* R_GetSkinFaceMini(player_t* ply);
-void R_FlushTranslationColormapCache(void);
+void R_UpdateTranslationColormaps(INT32 skinnum, boolean local);
 UINT8 R_GetColorByName(const char *name);
 
 // Custom player skin translation
@@ -170,6 +171,27 @@ void R_DrawFogSpan_8(void);
 void R_DrawFogColumn_8(void);
 void R_DrawColumnShadowed_8(void);
 
+#ifdef VECTORDRAWERS
+void R_DrawSpan_8_Vector(void);
+void R_DrawTranslucentSpan_8_Vector(void);
+void R_DrawSplat_8_Vector(void);
+void R_DrawTiltedSpan_8_Vector(void);
+void R_DrawTiltedTranslucentSpan_8_Vector(void);
+#ifndef NOWATER
+void R_DrawTiltedTranslucentWaterSpan_8_Vector(void);
+#endif
+void R_DrawTiltedSplat_8_Vector(void);
+
+#ifdef VECTORDRAWERS_AVX2
+boolean R_HasAVX2(void);
+void R_DrawSpan_8_AVX2(void);
+void R_DrawTranslucentSpan_8_AVX2(void);
+void R_DrawSplat_8_AVX2(void);
+#endif
+
+void R_DrawerBench_f(void);
+#endif
+
 // ------------------
 // 16bpp DRAWING CODE
 // ------------------
@@ -1540,6 +1540,590 @@ void R_DrawTranslucentSpan_8 (void)
 	}
 }
 
+#ifdef VECTORDRAWERS
+// ==========================================================================
+// VECTOR SPANS
+// ==========================================================================
+
+// The span drawers above spend most of their time working out flat offsets.
+// These work out eight offsets at once with SSE2 or NEON and then do the
+// same table lookups as the scalar drawers, so the output is identical.
+
+typedef struct
+{
+#ifdef __ARM_NEON
+	uint32x4_t x, y, xstep, ystep, mask;
+	int32x4_t xshift, yshift;
+#else
+	__m128i x, y, xstep, ystep, mask, xshift, yshift;
+#endif
+} spanvector_t;
+
+static inline void R_InitSpanVector(spanvector_t *v, UINT32 xposition, UINT32 yposition, UINT32 xstep, UINT32 ystep)
+{
+#ifdef __ARM_NEON
+	const UINT32 xs[4] = {xposition, xposition + xstep, xposition + 2*xstep, xposition + 3*xstep};
+	const UINT32 ys[4] = {yposition, yposition + ystep, yposition + 2*ystep, yposition + 3*ystep};
+
+	v->x = vld1q_u32(xs);
+	v->y = vld1q_u32(ys);
+	v->xstep = vdupq_n_u32(4*xstep);
+	v->ystep = vdupq_n_u32(4*ystep);
+	v->mask = vdupq_n_u32(nflatmask);
+	v->xshift = vdupq_n_s32(-(INT32)nflatxshift);
+	v->yshift = vdupq_n_s32(-(INT32)nflatyshift);
+#else
+	v->x = _mm_setr_epi32(xposition, xposition + xstep, xposition + 2*xstep, xposition + 3*xstep);
+	v->y = _mm_setr_epi32(yposition, yposition + ystep, yposition + 2*ystep, yposition + 3*ystep);
+	v->xstep = _mm_set1_epi32(4*xstep);
+	v->ystep = _mm_set1_epi32(4*ystep);
+	v->mask = _mm_set1_epi32(nflatmask);
+	v->xshift = _mm_cvtsi32_si128(nflatxshift);
+	v->yshift = _mm_cvtsi32_si128(nflatyshift);
+#endif
+}
+
+// Writes the flat offsets of the next eight pixels and steps past them.
+static inline void R_SpanVectorOffsets(spanvector_t *v, UINT32 *bits)
+{
+	INT32 i;
+
+	for (i = 0; i < 8; i += 4)
+	{
+#ifdef __ARM_NEON
+		vst1q_u32(bits + i, vorrq_u32(vandq_u32(vshlq_u32(v->y, v->yshift), v->mask), vshlq_u32(v->x, v->xshift)));
+		v->x = vaddq_u32(v->x, v->xstep);
+		v->y = vaddq_u32(v->y, v->ystep);
+#else
+		_mm_storeu_si128((__m128i *)(bits + i), _mm_or_si128(_mm_and_si128(_mm_srl_epi32(v->y, v->yshift), v->mask), _mm_srl_epi32(v->x, v->xshift)));
+		v->x = _mm_add_epi32(v->x, v->xstep);
+		v->y = _mm_add_epi32(v->y, v->ystep);
+#endif
+	}
+}
+
+// Position of the next pixel, for finishing the span one pixel at a time.
+static inline void R_SpanVectorPosition(const spanvector_t *v, UINT32 *xposition, UINT32 *yposition)
+{
+#ifdef __ARM_NEON
+	*xposition = vgetq_lane_u32(v->x, 0);
+	*yposition = vgetq_lane_u32(v->y, 0);
+#else
+	*xposition = (UINT32)_mm_cvtsi128_si32(v->x);
+	*yposition = (UINT32)_mm_cvtsi128_si32(v->y);
+#endif
+}
+
+/**	\brief The R_DrawSpan_8_Vector function
+	R_DrawSpan_8 with the flat offsets worked out eight at a time.
+*/
+void R_DrawSpan_8_Vector(void)
+{
+	UINT32 xposition, yposition;
+	UINT32 bits[8];
+	spanvector_t v;
+
+	const UINT8 *source = ds_source;
+	const UINT8 *colormap = ds_colormap;
+	UINT8 *dest = ylookup[ds_y] + columnofs[ds_x1];
+	const UINT8 *deststop = screens[0] + vid.rowbytes * vid.height;
+
+	size_t count = (ds_x2 - ds_x1 + 1);
+	size_t i;
+
+	if (dest+8 > deststop)
+		return;
+
+	R_InitSpanVector(&v, (UINT32)ds_xfrac << nflatshiftup, (UINT32)ds_yfrac << nflatshiftup,
+		(UINT32)ds_xstep << nflatshiftup, (UINT32)ds_ystep << nflatshiftup);
+
+	while (count >= 8)
+	{
+		R_SpanVectorOffsets(&v, bits);
+
+		for (i = 0; i < 8; i++)
+			dest[i] = colormap[source[bits[i]]];
+
+		dest += 8;
+		count -= 8;
+	}
+
+	R_SpanVectorPosition(&v, &xposition, &yposition);
+
+	while (count-- && dest <= deststop)
+	{
+		*dest++ = colormap[source[((yposition >> nflatyshift) & nflatmask) | (xposition >> nflatxshift)]];
+		xposition += (UINT32)ds_xstep << nflatshiftup;
+		yposition += (UINT32)ds_ystep << nflatshiftup;
+	}
+}
+
+/**	\brief The R_DrawTranslucentSpan_8_Vector function
+	R_DrawTranslucentSpan_8 with the flat offsets worked out eight at a time.
+*/
+void R_DrawTranslucentSpan_8_Vector(void)
+{
+	UINT32 xposition, yposition;
+	UINT32 bits[8];
+	spanvector_t v;
+
+	const UINT8 *source = ds_source;
+	const UINT8 *colormap = ds_colormap;
+	const UINT8 *transmap = ds_transmap;
+	UINT8 *dest = ylookup[ds_y] + columnofs[ds_x1];
+	const UINT8 *deststop = screens[0] + vid.rowbytes * vid.height;
+
+	size_t count = (ds_x2 - ds_x1 + 1);
+	size_t i;
+
+	R_InitSpanVector(&v, (UINT32)ds_xfrac << nflatshiftup, (UINT32)ds_yfrac << nflatshiftup,
+		(UINT32)ds_xstep << nflatshiftup, (UINT32)ds_ystep << nflatshiftup);
+
+	while (count >= 8)
+	{
+		R_SpanVectorOffsets(&v, bits);
+
+		for (i = 0; i < 8; i++)
+			dest[i] = *(transmap + (colormap[source[bits[i]]] << 8) + dest[i]);
+
+		dest += 8;
+		count -= 8;
+	}
+
+	R_SpanVectorPosition(&v, &xposition, &yposition);
+
+	while (count-- && dest <= deststop)
+	{
+		*dest = *(transmap + (colormap[source[((yposition >> nflatyshift) & nflatmask) | (xposition >> nflatxshift)]] << 8) + *dest);
+		dest++;
+		xposition += (UINT32)ds_xstep << nflatshiftup;
+		yposition += (UINT32)ds_ystep << nflatshiftup;
+	}
+}
+
+/**	\brief The R_DrawSplat_8_Vector function
+	R_DrawSplat_8 with the flat offsets worked out eight at a time.
+*/
+void R_DrawSplat_8_Vector(void)
+{
+	UINT32 xposition, yposition;
+	UINT32 bits[8];
+	spanvector_t v;
+
+	const UINT8 *source = ds_source;
+	const UINT8 *colormap = ds_colormap;
+	UINT8 *dest = ylookup[ds_y] + columnofs[ds_x1];
+
+	size_t count = ds_x2 - ds_x1 + 1;
+	size_t i;
+	UINT32 val;
+
+	R_InitSpanVector(&v, (UINT32)ds_xfrac << nflatshiftup, (UINT32)ds_yfrac << nflatshiftup,
+		(UINT32)ds_xstep << nflatshiftup, (UINT32)ds_ystep << nflatshiftup);
+
+	while (count >= 8)
+	{
+		R_SpanVectorOffsets(&v, bits);
+
+		for (i = 0; i < 8; i++)
+		{
+			val = source[bits[i] & MAXFLATBYTES];
+			if (val != TRANSPARENTPIXEL)
+				dest[i] = colormap[val];
+		}
+
+		dest += 8;
+		count -= 8;
+	}
+
+	R_SpanVectorPosition(&v, &xposition, &yposition);
+
+	while (count--)
+	{
+		val = source[((yposition >> nflatyshift) & nflatmask) | (xposition >> nflatxshift)];
+		if (val != TRANSPARENTPIXEL)
+			*dest = colormap[val];
+
+		dest++;
+		xposition += (UINT32)ds_xstep << nflatshiftup;
+		yposition += (UINT32)ds_ystep << nflatshiftup;
+	}
+}
+
+#ifdef VECTORDRAWERS_AVX2
+// AVX2 works out all eight offsets with one instruction each. These are built
+// for AVX2 whatever the rest of the game targets, so only call them when
+// R_HasAVX2 says the CPU can run them. The lookups stay one at a time, since
+// AVX2 gathers read four bytes a lane and would run off the end of the flat.
+
+#define AVX2DRAWER __attribute__((target("avx2")))
+
+typedef struct
+{
+	__m256i x, y, xstep, ystep, mask;
+	__m128i xshift, yshift;
+} spanvector256_t;
+
+static inline AVX2DRAWER void R_InitSpanVector256(spanvector256_t *v, UINT32 xposition, UINT32 yposition, UINT32 xstep, UINT32 ystep)
+{
+	v->x = _mm256_setr_epi32(xposition, xposition + xstep, xposition + 2*xstep, xposition + 3*xstep,
+		xposition + 4*xstep, xposition + 5*xstep, xposition + 6*xstep, xposition + 7*xstep);
+	v->y = _mm256_setr_epi32(yposition, yposition + ystep, yposition + 2*ystep, yposition + 3*ystep,
+		yposition + 4*ystep, yposition + 5*ystep, yposition + 6*ystep, yposition + 7*ystep);
+	v->xstep = _mm256_set1_epi32(8*xstep);
+	v->ystep = _mm256_set1_epi32(8*ystep);
+	v->mask = _mm256_set1_epi32(nflatmask);
+	v->xshift = _mm_cvtsi32_si128(nflatxshift);
+	v->yshift = _mm_cvtsi32_si128(nflatyshift);
+}
+
+static inline AVX2DRAWER void R_SpanVectorOffsets256(spanvector256_t *v, UINT32 *bits)
+{
+	_mm256_storeu_si256((__m256i *)bits, _mm256_or_si256(_mm256_and_si256(_mm256_srl_epi32(v->y, v->yshift), v->mask), _mm256_srl_epi32(v->x, v->xshift)));
+	v->x = _mm256_add_epi32(v->x, v->xstep);
+	v->y = _mm256_add_epi32(v->y, v->ystep);
+}
+
+static inline AVX2DRAWER void R_SpanVectorPosition256(const spanvector256_t *v, UINT32 *xposition, UINT32 *yposition)
+{
+	*xposition = (UINT32)_mm_cvtsi128_si32(_mm256_castsi256_si128(v->x));
+	*yposition = (UINT32)_mm_cvtsi128_si32(_mm256_castsi256_si128(v->y));
+}
+
+/**	\brief The R_DrawSpan_8_AVX2 function
+	R_DrawSpan_8_Vector with AVX2.
+*/
+AVX2DRAWER void R_DrawSpan_8_AVX2(void)
+{
+	UINT32 xposition, yposition;
+	UINT32 bits[8];
+	spanvector256_t v;
+
+	const UINT8 *source = ds_source;
+	const UINT8 *colormap = ds_colormap;
+	UINT8 *dest = ylookup[ds_y] + columnofs[ds_x1];
+	const UINT8 *deststop = screens[0] + vid.rowbytes * vid.height;
+
+	size_t count = (ds_x2 - ds_x1 + 1);
+	size_t i;
+
+	if (dest+8 > deststop)
+		return;
+
+	R_InitSpanVector256(&v, (UINT32)ds_xfrac << nflatshiftup, (UINT32)ds_yfrac << nflatshiftup,
+		(UINT32)ds_xstep << nflatshiftup, (UINT32)ds_ystep << nflatshiftup);
+
+	while (count >= 8)
+	{
+		R_SpanVectorOffsets256(&v, bits);
+
+		for (i = 0; i < 8; i++)
+			dest[i] = colormap[source[bits[i]]];
+
+		dest += 8;
+		count -= 8;
+	}
+
+	R_SpanVectorPosition256(&v, &xposition, &yposition);
+
+	while (count-- && dest <= deststop)
+	{
+		*dest++ = colormap[source[((yposition >> nflatyshift) & nflatmask) | (xposition >> nflatxshift)]];
+		xposition += (UINT32)ds_xstep << nflatshiftup;
+		yposition += (UINT32)ds_ystep << nflatshiftup;
+	}
+}
+
+/**	\brief The R_DrawTranslucentSpan_8_AVX2 function
+	R_DrawTranslucentSpan_8_Vector with AVX2.
+*/
+AVX2DRAWER void R_DrawTranslucentSpan_8_AVX2(void)
+{
+	UINT32 xposition, yposition;
+	UINT32 bits[8];
+	spanvector256_t v;
+
+	const UINT8 *source = ds_source;
+	const UINT8 *colormap = ds_colormap;
+	const UINT8 *transmap = ds_transmap;
+	UINT8 *dest = ylookup[ds_y] + columnofs[ds_x1];
+	const UINT8 *deststop = screens[0] + vid.rowbytes * vid.height;
+
+	size_t count = (ds_x2 - ds_x1 + 1);
+	size_t i;
+
+	R_InitSpanVector256(&v, (UINT32)ds_xfrac << nflatshiftup, (UINT32)ds_yfrac << nflatshiftup,
+		(UINT32)ds_xstep << nflatshiftup, (UINT32)ds_ystep << nflatshiftup);
+
+	while (count >= 8)
+	{
+		R_SpanVectorOffsets256(&v, bits);
+
+		for (i = 0; i < 8; i++)
+			dest[i] = *(transmap + (colormap[source[bits[i]]] << 8) + dest[i]);
+
+		dest += 8;
+		count -= 8;
+	}
+
+	R_SpanVectorPosition256(&v, &xposition, &yposition);
+
+	while (count-- && dest <= deststop)
+	{
+		*dest = *(transmap + (colormap[source[((yposition >> nflatyshift) & nflatmask) | (xposition >> nflatxshift)]] << 8) + *dest);
+		dest++;
+		xposition += (UINT32)ds_xstep << nflatshiftup;
+		yposition += (UINT32)ds_ystep << nflatshiftup;
+	}
+}
+
+/**	\brief The R_DrawSplat_8_AVX2 function
+	R_DrawSplat_8_Vector with AVX2.
+*/
+AVX2DRAWER void R_DrawSplat_8_AVX2(void)
+{
+	UINT32 xposition, yposition;
+	UINT32 bits[8];
+	spanvector256_t v;
+
+	const UINT8 *source = ds_source;
+	const UINT8 *colormap = ds_colormap;
+	UINT8 *dest = ylookup[ds_y] + columnofs[ds_x1];
+
+	size_t count = ds_x2 - ds_x1 + 1;
+	size_t i;
+	UINT32 val;
+
+	R_InitSpanVector256(&v, (UINT32)ds_xfrac << nflatshiftup, (UINT32)ds_yfrac << nflatshiftup,
+		(UINT32)ds_xstep << nflatshiftup, (UINT32)ds_ystep << nflatshiftup);
+
+	while (count >= 8)
+	{
+		R_SpanVectorOffsets256(&v, bits);
+
+		for (i = 0; i < 8; i++)
+		{
+			val = source[bits[i] & MAXFLATBYTES];
+			if (val != TRANSPARENTPIXEL)
+				dest[i] = colormap[val];
+		}
+
+		dest += 8;
+		count -= 8;
+	}
+
+	R_SpanVectorPosition256(&v, &xposition, &yposition);
+
+	while (count--)
+	{
+		val = source[((yposition >> nflatyshift) & nflatmask) | (xposition >> nflatxshift)];
+		if (val != TRANSPARENTPIXEL)
+			*dest = colormap[val];
+
+		dest++;
+		xposition += (UINT32)ds_xstep << nflatshiftup;
+		yposition += (UINT32)ds_ystep << nflatshiftup;
+	}
+}
+
+#undef AVX2DRAWER
+#endif // VECTORDRAWERS_AVX2
+
+// Flat offsets of every pixel in the current tilted span
+static UINT32 tiltoffsets[MAXVIDWIDTH];
+
+// R_CalcTiltedOffsets
+// Fills tiltoffsets for a tilted span of width+1 pixels starting at iz/uz/vz.
+// The perspective divide still happens once every SPANSIZE pixels like in the
+// scalar tilted drawers, but the offsets in between are stepped eight at a time.
+static void R_CalcTiltedOffsets(double iz, double uz, double vz, INT32 width)
+{
+	UINT32 *bits = tiltoffsets;
+	spanvector_t vec;
+	double startz, startu, startv;
+	double izstep, uzstep, vzstep;
+	double endz, endu, endv;
+	UINT32 u, v, stepu, stepv;
+
+	startz = 1.f/iz;
+	startu = uz*startz;
+	startv = vz*startz;
+
+	izstep = ds_szp->x * SPANSIZE;
+	uzstep = ds_sup->x * SPANSIZE;
+	vzstep = ds_svp->x * SPANSIZE;
+	width++;
+
+	while (width >= SPANSIZE)
+	{
+		iz += izstep;
+		uz += uzstep;
+		vz += vzstep;
+
+		endz = 1.f/iz;
+		endu = uz*endz;
+		endv = vz*endz;
+		stepu = (INT64)((endu - startu) * INVSPAN);
+		stepv = (INT64)((endv - startv) * INVSPAN);
+		u = (INT64)(startu) + viewx;
+		v = (INT64)(startv) + viewy;
+
+		R_InitSpanVector(&vec, u, v, stepu, stepv);
+		R_SpanVectorOffsets(&vec, bits);
+		R_SpanVectorOffsets(&vec, bits + 8);
+
+		bits += SPANSIZE;
+		startu = endu;
+		startv = endv;
+		width -= SPANSIZE;
+	}
+
+	if (width == 1)
+	{
+		// Yes, the scalar drawers leave out viewx/viewy here too
+		u = (INT64)(startu);
+		v = (INT64)(startv);
+		*bits = ((v >> nflatyshift) & nflatmask) | (u >> nflatxshift);
+	}
+	else if (width > 1)
+	{
+		double left = width;
+		iz += ds_szp->x * left;
+		uz += ds_sup->x * left;
+		vz += ds_svp->x * left;
+
+		endz = 1.f/iz;
+		endu = uz*endz;
+		endv = vz*endz;
+		left = 1.f/left;
+		stepu = (INT64)((endu - startu) * left);
+		stepv = (INT64)((endv - startv) * left);
+		u = (INT64)(startu) + viewx;
+		v = (INT64)(startv) + viewy;
+
+		for (; width != 0; width--)
+		{
+			*bits++ = ((v >> nflatyshift) & nflatmask) | (u >> nflatxshift);
+			u += stepu;
+			v += stepv;
+		}
+	}
+}
+
+// R_StartTiltedSpan
+// Works out the lighting and flat offsets of the current tilted span.
+static void R_StartTiltedSpan(INT32 width)
+{
+	double iz, uz, vz;
+
+	iz = ds_szp->z + ds_szp->y*(centery-ds_y) + ds_szp->x*(ds_x1-centerx);
+
+	// Lighting is simple. It's just linear interpolation from start to end
+	{
+		float planelightfloat = PLANELIGHTFLOAT;
+		float lightstart, lightend;
+
+		lightend = (iz + ds_szp->x*width) * planelightfloat;
+		lightstart = iz * planelightfloat;
+
+		R_CalcTiltedLighting(FLOAT_TO_FIXED(lightstart), FLOAT_TO_FIXED(lightend));
+	}
+
+	uz = ds_sup->z + ds_sup->y*(centery-ds_y) + ds_sup->x*(ds_x1-centerx);
+	vz = ds_svp->z + ds_svp->y*(centery-ds_y) + ds_svp->x*(ds_x1-centerx);
+
+	R_CalcTiltedOffsets(iz, uz, vz, width);
+}
+
+/**	\brief The R_DrawTiltedSpan_8_Vector function
+	R_DrawTiltedSpan_8 with the flat offsets worked out eight at a time.
+*/
+void R_DrawTiltedSpan_8_Vector(void)
+{
+	const INT32 width = ds_x2 - ds_x1;
+	INT32 i;
+
+	const UINT8 *source = ds_source;
+	const INT32 *light = tiltlighting + ds_x1;
+	const size_t cmoffset = ds_colormap - colormaps;
+	UINT8 *dest = ylookup[ds_y] + columnofs[ds_x1];
+
+	R_StartTiltedSpan(width);
+
+	for (i = 0; i <= width; i++)
+		dest[i] = planezlight[light[i]][cmoffset + source[tiltoffsets[i]]];
+}
+
+/**	\brief The R_DrawTiltedTranslucentSpan_8_Vector function
+	R_DrawTiltedTranslucentSpan_8 with the flat offsets worked out eight at a time.
+*/
+void R_DrawTiltedTranslucentSpan_8_Vector(void)
+{
+	const INT32 width = ds_x2 - ds_x1;
+	INT32 i;
+
+	const UINT8 *source = ds_source;
+	const UINT8 *transmap = ds_transmap;
+	const INT32 *light = tiltlighting + ds_x1;
+	const size_t cmoffset = ds_colormap - colormaps;
+	UINT8 *dest = ylookup[ds_y] + columnofs[ds_x1];
+
+	R_StartTiltedSpan(width);
+
+	for (i = 0; i <= width; i++)
+		dest[i] = *(transmap + (planezlight[light[i]][cmoffset + source[tiltoffsets[i]]] << 8) + dest[i]);
+}
+
+#ifndef NOWATER
+/**	\brief The R_DrawTiltedTranslucentWaterSpan_8_Vector function
+	R_DrawTiltedTranslucentWaterSpan_8 with the flat offsets worked out eight at a time.
+*/
+void R_DrawTiltedTranslucentWaterSpan_8_Vector(void)
+{
+	const INT32 width = ds_x2 - ds_x1;
+	INT32 i;
+
+	const UINT8 *source = ds_source;
+	const UINT8 *transmap = ds_transmap;
+	const INT32 *light = tiltlighting + ds_x1;
+	const size_t cmoffset = ds_colormap - colormaps;
+	UINT8 *dest = ylookup[ds_y] + columnofs[ds_x1];
+	const UINT8 *dsrc = screens[1] + (ds_y+ds_bgofs)*vid.width + ds_x1;
+
+	R_StartTiltedSpan(width);
+
+	for (i = 0; i <= width; i++)
+		dest[i] = *(transmap + (planezlight[light[i]][cmoffset + source[tiltoffsets[i]]] << 8) + dsrc[i]);
+}
+#endif
+
+/**	\brief The R_DrawTiltedSplat_8_Vector function
+	R_DrawTiltedSplat_8 with the flat offsets worked out eight at a time.
+*/
+void R_DrawTiltedSplat_8_Vector(void)
+{
+	const INT32 width = ds_x2 - ds_x1;
+	INT32 i;
+	UINT8 val;
+
+	const UINT8 *source = ds_source;
+	const INT32 *light = tiltlighting + ds_x1;
+	const size_t cmoffset = ds_colormap - colormaps;
+	UINT8 *dest = ylookup[ds_y] + columnofs[ds_x1];
+
+	R_StartTiltedSpan(width);
+
+	for (i = 0; i <= width; i++)
+	{
+		val = source[tiltoffsets[i]];
+
+		// the lighting only moves along on drawn pixels, same as R_DrawTiltedSplat_8
+		if (val != TRANSPARENTPIXEL)
+			dest[i] = planezlight[*light++][cmoffset + val];
+	}
+}
+#endif // VECTORDRAWERS
+
 #ifndef NOWATER
 void R_DrawTranslucentWaterSpan_8(void)
 {
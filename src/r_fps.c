@@ -89,6 +89,13 @@ static levelinterpolator_t **levelinterpolators;
 static size_t levelinterpolators_len;
 static size_t levelinterpolators_size;
 
+// Interpolators R_ApplyLevelInterpolators changed, for R_RestoreLevelInterpolators to undo
+static levelinterpolator_t **appliedinterpolators;
+static size_t appliedinterpolators_len;
+
+// Bumped once per drawn frame; sectors the renderer reaches are stamped with it
+UINT32 levelinterpframe;
+
 
 static inline fixed_t R_LerpFixed(fixed_t from, fixed_t to, fixed_t frac)
 {
@@ -393,6 +400,12 @@ static void AddInterpolator(levelinterpolator_t* interpolator)
 			PU_LEVEL,
 			NULL
 		);
+		appliedinterpolators = Z_Realloc(
+			(void*) appliedinterpolators,
+			sizeof(levelinterpolator_t*) * levelinterpolators_size,
+			PU_LEVEL,
+			NULL
+		);
 	}
 
 	levelinterpolators[levelinterpolators_len] = interpolator;
@@ -490,6 +503,55 @@ void R_InitializeLevelInterpolators(void)
 	levelinterpolators_len = 0;
 	levelinterpolators_size = 0;
 	levelinterpolators = NULL;
+	appliedinterpolators_len = 0;
+	appliedinterpolators = NULL;
+}
+
+//
+// R_MarkInterpolatedSector
+//
+// Stamps a sector the renderer reached, along with the sectors that
+// control its fake floors and FOFs, so their interpolators keep running.
+//
+void R_MarkInterpolatedSector(sector_t *sector)
+{
+	ffloor_t *rover;
+
+	if (sector->interpframe == levelinterpframe)
+		return;
+
+	sector->interpframe = levelinterpframe;
+
+	if (sector->heightsec != -1)
+		sectors[sector->heightsec].interpframe = levelinterpframe;
+
+	for (rover = sector->ffloors; rover; rover = rover->next)
+		sectors[rover->secnum].interpframe = levelinterpframe;
+}
+
+// Whether the interpolator's sector was drawn last frame. Anything that
+// wasn't is left at its real position; if it comes into view, it's a
+// single frame behind at most.
+static boolean LevelInterpolatorVisible(levelinterpolator_t *interp)
+{
+	const sector_t *sector;
+
+	switch (interp->type)
+	{
+	case LVLINTERP_SectorPlane:
+		sector = interp->sectorplane.sector;
+		break;
+	case LVLINTERP_SectorScroll:
+		sector = interp->sectorscroll.sector;
+		break;
+	case LVLINTERP_SideScroll:
+		sector = interp->sidescroll.side->sector;
+		break;
+	default:
+		return true;
+	}
+
+	return (levelinterpframe - sector->interpframe <= 1);
 }
 
 static void UpdateLevelInterpolatorState(levelinterpolator_t *interp)
@@ -501,31 +563,42 @@ static void UpdateLevelInterpolatorState(levelinterpolator_t *interp)
 	case LVLINTERP_SectorPlane:
 		interp->sectorplane.oldheight = interp->sectorplane.bakheight;
 		interp->sectorplane.bakheight = interp->sectorplane.ceiling ? interp->sectorplane.sector->ceilingheight : interp->sectorplane.sector->floorheight;
+		interp->moving = (interp->sectorplane.oldheight != interp->sectorplane.bakheight);
 		break;
 	case LVLINTERP_SectorScroll:
 		interp->sectorscroll.oldxoffs = interp->sectorscroll.bakxoffs;
 		interp->sectorscroll.bakxoffs = interp->sectorscroll.ceiling ? interp->sectorscroll.sector->ceiling_xoffs : interp->sectorscroll.sector->floor_xoffs;
 		interp->sectorscroll.oldyoffs = interp->sectorscroll.bakyoffs;
 		interp->sectorscroll.bakyoffs = interp->sectorscroll.ceiling ? interp->sectorscroll.sector->ceiling_yoffs : interp->sectorscroll.sector->floor_yoffs;
+		interp->moving = (interp->sectorscroll.oldxoffs != interp->sectorscroll.bakxoffs
+			|| interp->sectorscroll.oldyoffs != interp->sectorscroll.bakyoffs);
 		break;
 	case LVLINTERP_SideScroll:
 		interp->sidescroll.oldtextureoffset = interp->sidescroll.baktextureoffset;
 		interp->sidescroll.baktextureoffset = interp->sidescroll.side->textureoffset;
 		interp->sidescroll.oldrowoffset = interp->sidescroll.bakrowoffset;
 		interp->sidescroll.bakrowoffset = interp->sidescroll.side->rowoffset;
+		interp->moving = (interp->sidescroll.oldtextureoffset != interp->sidescroll.baktextureoffset
+			|| interp->sidescroll.oldrowoffset != interp->sidescroll.bakrowoffset);
 		break;
 	case LVLINTERP_Polyobj:
+		interp->moving = false;
 		for (i = 0; i < interp->polyobj.vertices_size; i++)
 		{
 			interp->polyobj.oldvertices[i * 2    ] = interp->polyobj.bakvertices[i * 2    ];
 			interp->polyobj.oldvertices[i * 2 + 1] = interp->polyobj.bakvertices[i * 2 + 1];
 			interp->polyobj.bakvertices[i * 2    ] = interp->polyobj.polyobj->vertices[i]->x;
 			interp->polyobj.bakvertices[i * 2 + 1] = interp->polyobj.polyobj->vertices[i]->y;
+			if (interp->polyobj.oldvertices[i * 2] != interp->polyobj.bakvertices[i * 2]
+				|| interp->polyobj.oldvertices[i * 2 + 1] != interp->polyobj.bakvertices[i * 2 + 1])
+				interp->moving = true;
 		}
 		interp->polyobj.oldcx = interp->polyobj.bakcx;
 		interp->polyobj.oldcy = interp->polyobj.bakcy;
 		interp->polyobj.bakcx = interp->polyobj.polyobj->centerPt.x;
 		interp->polyobj.bakcy = interp->polyobj.polyobj->centerPt.y;
+		if (interp->polyobj.oldcx != interp->polyobj.bakcx || interp->polyobj.oldcy != interp->polyobj.bakcy)
+			interp->moving = true;
 		break;
 	/*case LVLINTERP_DynSlope:
 		FV3_Copy(&interp->dynslope.oldo, &interp->dynslope.bako);
@@ -572,10 +645,23 @@ void R_ApplyLevelInterpolators(fixed_t frac)
 {
 	size_t i, ii;
 
+	levelinterpframe++;
+	appliedinterpolators_len = 0;
+
+	// At the end of the tic, everything already is where it should be.
+	if (frac == FRACUNIT)
+		return;
+
 	for (i = 0; i < levelinterpolators_len; i++)
 	{
 		levelinterpolator_t *interp = levelinterpolators[i];
 
+		// Didn't move last tic, or nobody is looking at it.
+		if (!interp->moving || !LevelInterpolatorVisible(interp))
+			continue;
+
+		appliedinterpolators[appliedinterpolators_len++] = interp;
+
 		switch (interp->type)
 		{
 		case LVLINTERP_SectorPlane:
@@ -623,9 +709,9 @@ void R_RestoreLevelInterpolators(void)
 {
 	size_t i, ii;
 
-	for (i = 0; i < levelinterpolators_len; i++)
+	for (i = 0; i < appliedinterpolators_len; i++)
 	{
-		levelinterpolator_t *interp = levelinterpolators[i];
+		levelinterpolator_t *interp = appliedinterpolators[i];
 
 		switch (interp->type)
 		{
@@ -672,6 +758,8 @@ void R_RestoreLevelInterpolators(void)
 			break;*/
 		}
 	}
+
+	appliedinterpolators_len = 0;
 }
 
 void R_DestroyLevelInterpolators(thinker_t *thinker)
@@ -721,6 +809,7 @@ void R_AddMobjInterpolator(mobj_t *mobj)
 		);
 	}
 
+	mobj->interpindex = interpolated_mobjs_len;
 	interpolated_mobjs[interpolated_mobjs_len] = mobj;
 	interpolated_mobjs_len += 1;
 
@@ -728,20 +817,33 @@ void R_AddMobjInterpolator(mobj_t *mobj)
 	mobj->resetinterp = true;
 }
 
+// Swaps the tail of the list into the removed slot, so the list stays
+// packed for R_UpdateMobjInterpolators.
+static void RemoveMobjInterpolatorAt(size_t i)
+{
+	interpolated_mobjs_len -= 1;
+	interpolated_mobjs[i] = interpolated_mobjs[interpolated_mobjs_len];
+	interpolated_mobjs[i]->interpindex = i;
+}
+
 void R_RemoveMobjInterpolator(mobj_t *mobj)
 {
 	size_t i;
 
 	if (interpolated_mobjs_len == 0) return;
 
+	// Mobjs remember their slot, so removing one doesn't scan the list.
+	if (mobj->interpindex < interpolated_mobjs_len && interpolated_mobjs[mobj->interpindex] == mobj)
+	{
+		RemoveMobjInterpolatorAt(mobj->interpindex);
+		return;
+	}
+
 	for (i = 0; i < interpolated_mobjs_len; i++)
 	{
 		if (interpolated_mobjs[i] == mobj)
 		{
-			interpolated_mobjs[i] = interpolated_mobjs[
-				interpolated_mobjs_len - 1
-			];
-			interpolated_mobjs_len -= 1;
+			RemoveMobjInterpolatorAt(i);
 			return;
 		}
 	}
@@ -55,6 +55,8 @@ typedef struct {
 
 extern viewvars_t *newview;
 
+extern UINT32 levelinterpframe;
+
 typedef struct {
 	fixed_t x;
 	fixed_t y;
@@ -85,6 +87,7 @@ typedef enum {
 typedef struct levelinterpolator_s {
 	levelinterpolator_type_e type;
 	thinker_t *thinker;
+	boolean moving; // old and current state differ, so there is something to interpolate
 	union {
 		struct {
 			sector_t *sector;
@@ -150,6 +153,8 @@ void R_InitializeLevelInterpolators(void);
 void R_UpdateLevelInterpolators(void);
 // Clear states for all level interpolators for the thinker
 void R_ClearLevelInterpolatorState(thinker_t *thinker);
+// Mark a sector as reached by the renderer, so its level interpolators are applied next frame
+void R_MarkInterpolatedSector(sector_t *sector);
 // Apply level interpolators to the actual game state
 void R_ApplyLevelInterpolators(fixed_t frac);
 // Restore level interpolators to the real game state
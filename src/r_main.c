@@ -34,6 +34,8 @@
 #include "r_portal.h"
 #include "doomstat.h" // MAXSPLITSCREENPLAYERS
 #include "r_fps.h" // Frame interpolation/uncapped
+#include "p_setup.h" // levelflats
+#include "p_polyobj.h"
 #include "tables.h"
 
 #ifdef HWRENDER
@@ -103,6 +105,7 @@ ps_metric_t ps_rendercalltime = {0};
 ps_metric_t ps_otherrendertime = {0};
 ps_metric_t ps_uitime = {0};
 ps_metric_t ps_swaptime = {0};
+ps_metric_t ps_sw_presenttime = {0};
 
 ps_metric_t ps_skyboxtime = {0};
 ps_metric_t ps_bsptime = {0};
@@ -111,6 +114,17 @@ ps_metric_t ps_sw_spritecliptime = {0};
 ps_metric_t ps_sw_portaltime = {0};
 ps_metric_t ps_sw_planetime = {0};
 ps_metric_t ps_sw_maskedtime = {0};
+ps_metric_t ps_sw_spritesorttime = {0};
+ps_metric_t ps_sw_numvisplanes = {0};
+ps_metric_t ps_sw_numrotations = {0};
+ps_metric_t ps_sw_drawsegtests = {0};
+ps_metric_t ps_sw_clippedsprites = {0};
+ps_metric_t ps_sw_drawsegspersprite = {0};
+ps_metric_t ps_sw_rotspritememory = {0};
+ps_metric_t ps_sw_skyboxsaved = {0};
+ps_metric_t ps_sw_numplanespans = {0};
+ps_metric_t ps_sw_planepixels = {0};
+ps_metric_t ps_sw_planespanlength = {0};
 
 ps_metric_t ps_numbspcalls = {0};
 ps_metric_t ps_numsprites = {0};
@@ -173,6 +187,7 @@ consvar_t cv_flipcam4 = {"flipcam4", "No", CV_SAVE|CV_CALL|CV_NOINIT, CV_YesNo,
 consvar_t cv_shadow = {"shadow", "Off", CV_SAVE, CV_OnOff, NULL, 0, NULL, NULL, 0, 0, NULL};
 consvar_t cv_shadowoffs = {"offsetshadows", "Off", CV_SAVE, CV_OnOff, NULL, 0, NULL, NULL, 0, 0, NULL};
 consvar_t cv_skybox = {"skybox", "On", CV_SAVE, CV_OnOff, NULL, 0, NULL, NULL, 0, 0, NULL};
+consvar_t cv_skyboxcache = {"skyboxcache", "Off", CV_SAVE, CV_OnOff, NULL, 0, NULL, NULL, 0, 0, NULL};
 consvar_t cv_ffloorclip = {"r_ffloorclip", "On", CV_SAVE, CV_OnOff, NULL, 0, NULL, NULL, 0, 0, NULL};
 consvar_t cv_spriteclip = {"r_spriteclip", "On", CV_SAVE, CV_OnOff, NULL, 0, NULL, NULL, 0, 0, NULL};
 consvar_t cv_soniccd = {"soniccd", "Off", CV_NETVAR|CV_NOSHOWHELP, CV_OnOff, NULL, 0, NULL, NULL, 0, 0, NULL};
@@ -191,6 +206,15 @@ consvar_t cv_maxinterpdist = {"maxinterpdist", "Infinite", CV_SAVE, maxinterpdis
 
 consvar_t cv_ripplewater = {"waterripples", "On", CV_SAVE, CV_OnOff, NULL, 0, NULL, NULL, 0, 0, NULL};
 
+// Megabytes of composited wall textures and rotated sprites kept around,
+// see R_EvictTextures and RotatedPatch_Trim
+static CV_PossibleValue_t texturecachesize_cons_t[] = {{8, "MIN"}, {1024, "MAX"}, {0, NULL}};
+consvar_t cv_texturecachesize = {"texturecachesize", "128", CV_SAVE|CV_CALL|CV_NOINIT, texturecachesize_cons_t, R_TrimTextureCache, 0, NULL, NULL, 0, 0, NULL};
+#ifdef ROTSPRITE
+static CV_PossibleValue_t rotspritecachesize_cons_t[] = {{4, "MIN"}, {1024, "MAX"}, {0, NULL}};
+consvar_t cv_rotspritecachesize = {"rotspritecachesize", "64", CV_SAVE|CV_CALL|CV_NOINIT, rotspritecachesize_cons_t, RotatedPatch_Trim, 0, NULL, NULL, 0, 0, NULL};
+#endif
+
 // cap fov, fov too high tears software apart.
 consvar_t cv_fov = {"fov", "90", CV_FLOAT|CV_CALL|CV_SAVE, fov_cons_t, Fov_OnChange, 0, NULL, NULL, 0, 0, NULL};
 
@@ -199,6 +223,12 @@ consvar_t cv_homremoval = {"homremoval", "Yes", CV_SAVE, homremoval_cons_t, NULL
 
 consvar_t cv_maxportals = {"maxportals", "2", CV_SAVE, maxportals_cons_t, NULL, 0, NULL, NULL, 0, 0, NULL};
 
+#ifdef HAVE_THREADS
+// Threads drawing floors and ceilings, see R_DrawPlanes
+static CV_PossibleValue_t renderthreads_cons_t[] = {{1, "MIN"}, {MAXRENDERTHREADS, "MAX"}, {0, NULL}};
+consvar_t cv_renderthreads = {"renderthreads", "1", CV_SAVE, renderthreads_cons_t, NULL, 0, NULL, NULL, 0, 0, NULL};
+#endif
+
 void SplitScreen_OnChange(void)
 {
 	UINT8 i;
@@ -274,22 +304,7 @@ static void Precipstuff_OnChange(void)
 	if (gamestate != GS_LEVEL)
 		return;
 
-	thinker_t *think;
-	thinker_t *next;
-	precipmobj_t *precipmobj;
-
-	for (think = thinkercap.next; think != &thinkercap; think = next)
-	{
-		next = think->next;
-
-		if (think->function.acp1 != (actionf_p1)P_NullPrecipThinker)
-			continue; // not a precipmobj thinker
-
-		precipmobj = (precipmobj_t *)think;
-		P_FreePrecipMobj(precipmobj);
-	}
-
-	P_SpawnPrecipitation();
+	P_ResetPrecipitation();
 }
 
 //
@@ -1329,6 +1344,292 @@ void R_SkyboxFrame(player_t *player)
 	R_InterpolateView(R_UsingFrameInterpolation() ? (demo.playback && demo.freecam) ? rendertimefrac_unpaused : rendertimefrac : FRACUNIT, false);
 }
 
+//
+// Skybox cache
+//
+// With skyboxcache on, the software renderer keeps what the skybox pass
+// drew for each view. The next frame copies it back instead of rendering
+// the skybox again, as long as the skybox view is the same and nothing
+// the pass reached has changed. The main view then draws over it like
+// it always does.
+//
+typedef struct
+{
+	fixed_t x, y, z;
+	angle_t angle, aim, roll;
+	fixed_t centeryfrac, projection, projectiony;
+	INT32 width, height;
+	UINT8 *dest; // top left of the view, tells splitscreen viewports and resolutions apart
+	mobj_t *viewmobj;
+	lighttable_t *colormaps;
+} skyboxkey_t;
+
+typedef struct
+{
+	boolean valid;
+	skyboxkey_t key;
+	UINT32 signature;
+	precise_t cost; // how long rendering it took
+	UINT8 *pixels;
+	size_t *sectors; // sectors the pass reached
+	size_t numsectors, maxsectors;
+} skyboxcache_t;
+
+static skyboxcache_t skyboxcache[MAXSPLITSCREENPLAYERS];
+static UINT8 *skyboxsectorseen; // PU_LEVEL, goes away with the level's sectors
+boolean skyboxrecording;
+
+#define SKYBOXMIX(sig, v) sig = ((sig) ^ (UINT32)(v)) * 16777619U
+
+static void R_GetSkyboxKey(skyboxkey_t *key)
+{
+	memset(key, 0, sizeof (*key));
+	key->x = viewx;
+	key->y = viewy;
+	key->z = viewz;
+	key->angle = viewangle;
+	key->aim = aimingangle;
+	key->roll = viewroll;
+	key->centeryfrac = centeryfrac;
+	key->projection = projection;
+	key->projectiony = projectiony;
+	key->width = viewwidth;
+	key->height = viewheight;
+	key->dest = ylookup[0] + columnofs[0];
+	key->viewmobj = skyboxmo[0];
+	key->colormaps = colormaps;
+}
+
+static UINT32 R_SkyboxSectorSignature(UINT32 sig, const sector_t *sec)
+{
+	SKYBOXMIX(sig, sec->floorheight);
+	SKYBOXMIX(sig, sec->ceilingheight);
+	SKYBOXMIX(sig, sec->lightlevel);
+	SKYBOXMIX(sig, levelflats[sec->floorpic].lumpnum);
+	SKYBOXMIX(sig, levelflats[sec->ceilingpic].lumpnum);
+	SKYBOXMIX(sig, sec->floor_xoffs);
+	SKYBOXMIX(sig, sec->floor_yoffs);
+	SKYBOXMIX(sig, sec->ceiling_xoffs);
+	SKYBOXMIX(sig, sec->ceiling_yoffs);
+	SKYBOXMIX(sig, (size_t)sec->extra_colormap);
+	return sig;
+}
+
+// Hashes everything in the recorded sectors that can change what the
+// skybox pass draws: planes, lights, wall textures and the things in them.
+static UINT32 R_SkyboxSignature(const skyboxcache_t *cache)
+{
+	UINT32 sig = 2166136261U;
+	size_t i, j;
+	INT32 p;
+
+	SKYBOXMIX(sig, texturetranslation[skytexture]);
+
+	// Precipitation falls a little further every frame.
+	if (curWeather != PRECIP_NONE)
+	{
+		SKYBOXMIX(sig, leveltime);
+		SKYBOXMIX(sig, rendertimefrac);
+	}
+
+	for (i = 0; i < cache->numsectors; i++)
+	{
+		const sector_t *sec = &sectors[cache->sectors[i]];
+		ffloor_t *rover;
+		mobj_t *thing;
+
+		sig = R_SkyboxSectorSignature(sig, sec);
+
+		if (sec->heightsec != -1)
+			sig = R_SkyboxSectorSignature(sig, &sectors[sec->heightsec]);
+
+		for (rover = sec->ffloors; rover; rover = rover->next)
+		{
+			SKYBOXMIX(sig, rover->flags);
+			SKYBOXMIX(sig, rover->alpha);
+			sig = R_SkyboxSectorSignature(sig, &sectors[rover->secnum]);
+		}
+
+		for (j = 0; j < sec->linecount; j++)
+		{
+			const line_t *line = sec->lines[j];
+			INT32 s;
+
+			for (s = 0; s < 2; s++)
+			{
+				const side_t *side;
+
+				if (line->sidenum[s] == 0xffff)
+					continue;
+
+				side = &sides[line->sidenum[s]];
+				SKYBOXMIX(sig, texturetranslation[side->toptexture]);
+				SKYBOXMIX(sig, texturetranslation[side->midtexture]);
+				SKYBOXMIX(sig, texturetranslation[side->bottomtexture]);
+				SKYBOXMIX(sig, side->textureoffset);
+				SKYBOXMIX(sig, side->rowoffset);
+			}
+		}
+
+		for (thing = sec->thinglist; thing; thing = thing->snext)
+		{
+			SKYBOXMIX(sig, thing->x);
+			SKYBOXMIX(sig, thing->y);
+			SKYBOXMIX(sig, thing->z);
+			SKYBOXMIX(sig, thing->angle);
+			SKYBOXMIX(sig, thing->sprite);
+			SKYBOXMIX(sig, thing->frame);
+			SKYBOXMIX(sig, thing->flags2); // MF2_SHADOW translucency
+			SKYBOXMIX(sig, thing->eflags); // flipped things
+			SKYBOXMIX(sig, thing->color);
+			SKYBOXMIX(sig, thing->colorized);
+			SKYBOXMIX(sig, (size_t)thing->skin);
+			SKYBOXMIX(sig, (size_t)thing->localskin);
+			SKYBOXMIX(sig, thing->skinlocal);
+			SKYBOXMIX(sig, thing->mirrored);
+			SKYBOXMIX(sig, thing->scale);
+
+			// Anything that rolls, squashes or shifts the sprite
+			SKYBOXMIX(sig, thing->rollangle);
+			SKYBOXMIX(sig, thing->pitch);
+			SKYBOXMIX(sig, thing->roll);
+			SKYBOXMIX(sig, thing->sloperoll);
+			SKYBOXMIX(sig, thing->slopepitch);
+			SKYBOXMIX(sig, thing->spritexscale);
+			SKYBOXMIX(sig, thing->spriteyscale);
+			SKYBOXMIX(sig, thing->spritexoffset);
+			SKYBOXMIX(sig, thing->spriteyoffset);
+			SKYBOXMIX(sig, thing->realxscale);
+			SKYBOXMIX(sig, thing->realyscale);
+			SKYBOXMIX(sig, thing->stretchslam);
+
+			// Moving things are drawn somewhere new every frame.
+			if (thing->x != thing->old_x || thing->y != thing->old_y || thing->z != thing->old_z)
+				SKYBOXMIX(sig, rendertimefrac);
+		}
+	}
+
+	for (p = 0; p < numPolyObjects; p++)
+	{
+		SKYBOXMIX(sig, PolyObjects[p].centerPt.x);
+		SKYBOXMIX(sig, PolyObjects[p].centerPt.y);
+		SKYBOXMIX(sig, PolyObjects[p].angle);
+	}
+
+	return sig;
+}
+
+//
+// R_RecordSkyboxSector
+//
+// Called by the BSP walk for every sector the skybox pass reaches
+// while skyboxrecording is set.
+//
+void R_RecordSkyboxSector(sector_t *sector)
+{
+	skyboxcache_t *cache = &skyboxcache[viewssnum];
+	const size_t num = sector - sectors;
+
+	if (skyboxsectorseen[num])
+		return;
+
+	skyboxsectorseen[num] = 1;
+
+	if (cache->numsectors >= cache->maxsectors)
+	{
+		cache->maxsectors = cache->maxsectors ? cache->maxsectors*2 : 64;
+		cache->sectors = Z_Realloc(cache->sectors, cache->maxsectors * sizeof (*cache->sectors), PU_STATIC, NULL);
+	}
+
+	cache->sectors[cache->numsectors++] = num;
+}
+
+//
+// R_ReuseSkyboxCache
+//
+// Draws the cached skybox for this view if it's still good.
+// Otherwise, gets ready to record the skybox pass and returns false.
+//
+static boolean R_ReuseSkyboxCache(void)
+{
+	skyboxcache_t *cache = &skyboxcache[viewssnum];
+	skyboxkey_t key;
+	precise_t elapsed;
+	INT32 y;
+
+	if (!cv_skyboxcache.value || vid.bpp != 1)
+	{
+		cache->valid = false;
+		return false;
+	}
+
+	// New level, the sectors we recorded are gone.
+	// The buffers are kept for the next recording.
+	if (!skyboxsectorseen)
+	{
+		for (y = 0; y < MAXSPLITSCREENPLAYERS; y++)
+		{
+			skyboxcache[y].valid = false;
+			skyboxcache[y].numsectors = 0;
+		}
+		Z_Calloc(numsectors, PU_LEVEL, &skyboxsectorseen);
+	}
+
+	R_GetSkyboxKey(&key);
+
+	if (cache->valid && !memcmp(&key, &cache->key, sizeof (key))
+		&& R_SkyboxSignature(cache) == cache->signature)
+	{
+		for (y = 0; y < viewheight; y++)
+			M_Memcpy(ylookup[y] + columnofs[0], cache->pixels + y*viewwidth, viewwidth);
+
+		// The skybox's own moving sectors are still being looked at.
+		for (y = 0; y < (INT32)cache->numsectors; y++)
+			R_MarkInterpolatedSector(&sectors[cache->sectors[y]]);
+
+		elapsed = I_GetPreciseTime() - ps_skyboxtime.value.p;
+		if (cache->cost > elapsed)
+			ps_sw_skyboxsaved.value.p = cache->cost - elapsed;
+		return true;
+	}
+
+	cache->valid = false;
+	cache->key = key;
+	cache->numsectors = 0;
+	skyboxrecording = true;
+	return false;
+}
+
+//
+// R_StoreSkyboxCache
+//
+// Keeps what the skybox pass just drew, and what it was drawn from.
+//
+static void R_StoreSkyboxCache(void)
+{
+	skyboxcache_t *cache = &skyboxcache[viewssnum];
+	size_t i;
+	INT32 y;
+
+	if (!skyboxrecording)
+		return;
+
+	skyboxrecording = false;
+
+	for (i = 0; i < cache->numsectors; i++)
+		skyboxsectorseen[cache->sectors[i]] = 0;
+
+	cache->pixels = Z_Realloc(cache->pixels, viewwidth * viewheight, PU_STATIC, NULL);
+	for (y = 0; y < viewheight; y++)
+		M_Memcpy(cache->pixels + y*viewwidth, ylookup[y] + columnofs[0], viewwidth);
+
+	cache->signature = R_SkyboxSignature(cache);
+	cache->cost = I_GetPreciseTime() - ps_skyboxtime.value.p;
+	cache->valid = true;
+}
+
+#undef SKYBOXMIX
+
 void R_SetupFrame(player_t *player, boolean skybox)
 {
 	camera_t *thiscam;
@@ -1552,10 +1853,11 @@ void R_RenderPlayerView(player_t *player)
 	Portal_InitList();
 	
 	PS_START_TIMING(ps_skyboxtime);
+	ps_sw_skyboxsaved.value.p = 0;
 	if (skybox && skyVisible)
-	{
 		R_SkyboxFrame(player);
-
+	if (skybox && skyVisible && !R_ReuseSkyboxCache())
+	{
 		R_ClearClipSegs();
 		R_ClearDrawSegs();
 		R_ClearPlanes();
@@ -1571,6 +1873,7 @@ void R_RenderPlayerView(player_t *player)
 		R_DrawVisibleFloorSplats();
 #endif
 		R_DrawMasked();
+		R_StoreSkyboxCache();
 	}
 	PS_STOP_TIMING(ps_skyboxtime);
 
@@ -1604,6 +1907,9 @@ void R_RenderPlayerView(player_t *player)
 	// The head node is the last node output.
 
 	ps_numbspcalls.value.i = ps_numpolyobjects.value.i = ps_numdrawnodes.value.i = 0;
+	ps_sw_numvisplanes.value.i = ps_sw_numplanespans.value.i = ps_sw_planepixels.value.i = 0;
+	ps_sw_numrotations.value.i = 0;
+	ps_sw_drawsegtests.value.i = ps_sw_clippedsprites.value.i = 0;
 	PS_START_TIMING(ps_bsptime);
 	R_RenderBSPNode((INT32)numnodes - 1);
 	PS_STOP_TIMING(ps_bsptime);
@@ -1662,6 +1968,10 @@ void R_RenderPlayerView(player_t *player)
 	R_DrawMasked();
 	PS_STOP_TIMING(ps_sw_maskedtime);
 
+	// FOF planes are drawn in R_DrawMasked, so wait for those too
+	ps_sw_planespanlength.value.i = ps_sw_numplanespans.value.i ? ps_sw_planepixels.value.i / ps_sw_numplanespans.value.i : 0;
+	ps_sw_drawsegspersprite.value.i = ps_sw_clippedsprites.value.i ? ps_sw_drawsegtests.value.i / ps_sw_clippedsprites.value.i : 0;
+
 	// save value to skyVisiblePerPlayer
 	// this is so that P1 can't affect whether P2 can see a skybox or not, or vice versa
 	for (i = 0; i <= splitscreen; i++)
@@ -1708,6 +2018,7 @@ void R_RegisterEngineStuff(void)
 	CV_RegisterVar(&cv_shadow);
 	CV_RegisterVar(&cv_shadowoffs);
 	CV_RegisterVar(&cv_skybox);
+	CV_RegisterVar(&cv_skyboxcache);
 	CV_RegisterVar(&cv_ffloorclip);
 	CV_RegisterVar(&cv_spriteclip);
 
@@ -1763,6 +2074,17 @@ void R_RegisterEngineStuff(void)
 	CV_RegisterVar(&cv_maxinterpdist);
 
 	CV_RegisterVar(&cv_ripplewater);
+	CV_RegisterVar(&cv_texturecachesize);
+#ifdef ROTSPRITE
+	CV_RegisterVar(&cv_rotspritecachesize);
+#endif
+	COM_AddCommand("texturecachestats", R_TextureCacheStats_f);
+#ifdef HAVE_THREADS
+	CV_RegisterVar(&cv_renderthreads);
+#endif
+#ifdef VECTORDRAWERS
+	COM_AddCommand("drawerbench", R_DrawerBench_f);
+#endif
 
 	// Default viewheight is changeable,
 	// initialized to standard viewheight
@@ -107,6 +107,7 @@ extern ps_metric_t ps_rendercalltime;
 extern ps_metric_t ps_otherrendertime;
 extern ps_metric_t ps_uitime;
 extern ps_metric_t ps_swaptime;
+extern ps_metric_t ps_sw_presenttime;
 
 extern ps_metric_t ps_skyboxtime;
 extern ps_metric_t ps_bsptime;
@@ -115,6 +116,17 @@ extern ps_metric_t ps_sw_spritecliptime;
 extern ps_metric_t ps_sw_portaltime;
 extern ps_metric_t ps_sw_planetime;
 extern ps_metric_t ps_sw_maskedtime;
+extern ps_metric_t ps_sw_spritesorttime;
+extern ps_metric_t ps_sw_numvisplanes;
+extern ps_metric_t ps_sw_numplanespans;
+extern ps_metric_t ps_sw_planepixels;
+extern ps_metric_t ps_sw_planespanlength;
+extern ps_metric_t ps_sw_numrotations;
+extern ps_metric_t ps_sw_rotspritememory;
+extern ps_metric_t ps_sw_skyboxsaved;
+extern ps_metric_t ps_sw_drawsegtests;
+extern ps_metric_t ps_sw_clippedsprites;
+extern ps_metric_t ps_sw_drawsegspersprite;
 
 extern ps_metric_t ps_numbspcalls;
 extern ps_metric_t ps_numsprites;
@@ -134,10 +146,15 @@ extern consvar_t cv_ffloorclip, cv_spriteclip;
 extern consvar_t cv_translucency;
 extern consvar_t cv_drawdist, cv_drawdist_precip, cv_lessprecip, cv_mobjscaleprecip;
 extern consvar_t cv_fov;
-extern consvar_t cv_skybox;
+extern consvar_t cv_skybox, cv_skyboxcache;
 extern consvar_t cv_tailspickup;
 extern consvar_t cv_maxinterpdist;
 extern consvar_t cv_ripplewater;
+extern consvar_t cv_texturecachesize, cv_rotspritecachesize;
+#ifdef HAVE_THREADS
+#define MAXRENDERTHREADS 16
+extern consvar_t cv_renderthreads;
+#endif
 
 // Called by startup code.
 void R_Init(void);
@@ -155,6 +172,10 @@ void R_ExecuteSetViewSize(void);
 
 void R_SkyboxFrame(player_t *player);
 
+// set while the skybox pass is being recorded for skyboxcache
+extern boolean skyboxrecording;
+void R_RecordSkyboxSector(sector_t *sector);
+
 void R_SetupFrame(player_t *player, boolean skybox);
 // Called by G_Drawer.
 void R_RenderPlayerView(player_t *player);
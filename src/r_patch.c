@@ -17,6 +17,7 @@
 #include "i_video.h"
 #include "r_data.h"
 #include "r_draw.h"
+#include "r_main.h"
 #include "r_patch.h"
 #include "r_things.h"
 #include "z_zone.h"
@@ -803,7 +804,137 @@ INT32 R_GetRollAngle(angle_t rollangle)
 	return ra;
 }
 
-patch_t *Patch_GetRotatedSprite(spriteframe_t *sprite, size_t frame, size_t spriteangle, boolean flip, boolean adjustfeet, void *info, INT32 rotationangle)
+//
+// Rotated patch cache
+//
+// Software rotations are kept on an LRU list, up to cv_rotspritecachesize
+// megabytes. Past that, the least recently used ones are freed, but never one
+// used in the current frame, since vissprites may still point to it.
+// OpenGL rotations are left alone, as they own hardware textures, and so
+// are ones handed to Lua, which can hold on to them for as long as it likes.
+//
+// Rotating is slow enough that a lot of sprites hitting new angles at once
+// can hitch, so only ROTATIONSPERFRAME patches get rotated each frame. Past
+// that, a cached neighbour up to ROTATIONFALLBACK angles away gets used
+// instead, and the exact angle is made when a later frame has time for it.
+//
+#define ROTATIONSPERFRAME 16
+#define ROTATIONFALLBACK 2
+
+static rotspriteslot_t *rotslothead, *rotslottail;
+static size_t rotspritebytes;
+static size_t rotationframe;
+static INT32 rotationsthisframe;
+
+static void RotatedPatch_Unlink(rotspriteslot_t *slot)
+{
+	if (slot->prev)
+		slot->prev->next = slot->next;
+	else
+		rotslothead = slot->next;
+
+	if (slot->next)
+		slot->next->prev = slot->prev;
+	else
+		rotslottail = slot->prev;
+}
+
+static void RotatedPatch_Link(rotspriteslot_t *slot)
+{
+	slot->prev = NULL;
+	slot->next = rotslothead;
+
+	if (rotslothead)
+		rotslothead->prev = slot;
+	else
+		rotslottail = slot;
+
+	rotslothead = slot;
+}
+
+static void RotatedPatch_Touch(rotspriteslot_t *slot)
+{
+	slot->lastused = framecount;
+
+	if (rotslothead != slot)
+	{
+		RotatedPatch_Unlink(slot);
+		RotatedPatch_Link(slot);
+	}
+}
+
+static void RotatedPatch_Evict(rotspriteslot_t *slot)
+{
+	RotatedPatch_Unlink(slot);
+	rotspritebytes -= slot->size;
+	Z_Free(*slot->patch); // clears the patch pointer
+	slot->patch = NULL;
+}
+
+//
+// RotatedPatch_Trim
+//
+// Frees the least recently used rotations until the cache fits its budget.
+//
+void RotatedPatch_Trim(void)
+{
+	const size_t budget = (size_t)cv_rotspritecachesize.value << 20;
+
+	while (rotspritebytes > budget && rotslottail && rotslottail->lastused != framecount)
+		RotatedPatch_Evict(rotslottail);
+
+	ps_sw_rotspritememory.value.i = (INT32)(rotspritebytes >> 10);
+}
+
+// Returns whether another patch may be rotated this frame
+static boolean RotatedPatch_CanRotate(void)
+{
+	if (rotationframe != framecount)
+	{
+		rotationframe = framecount;
+		rotationsthisframe = 0;
+	}
+
+	return (rotationsthisframe < ROTATIONSPERFRAME);
+}
+
+// Finds an already rotated patch close to angle idx, or NULL
+static patch_t *RotatedPatch_Nearest(rotsprite_t *rotsprite, INT32 idx)
+{
+	const INT32 base = (idx >= rotsprite->angles) ? rotsprite->angles : 0;
+	const INT32 angle = idx - base;
+	INT32 i, j, k;
+
+	for (i = 1; i <= ROTATIONFALLBACK; i++)
+	{
+		for (k = 0; k < 2; k++)
+		{
+			j = (angle + (k ? -i : i) + rotsprite->angles) % rotsprite->angles;
+			if (!j || !rotsprite->patches[base + j])
+				continue;
+
+			if (rotsprite->slots[base + j].patch)
+				RotatedPatch_Touch(&rotsprite->slots[base + j]);
+			return rotsprite->patches[base + j];
+		}
+	}
+
+	return NULL;
+}
+
+// Takes a rotation off the list for good
+static void RotatedPatch_Pin(rotspriteslot_t *slot)
+{
+	if (!slot->patch)
+		return;
+
+	RotatedPatch_Unlink(slot);
+	rotspritebytes -= slot->size;
+	slot->patch = NULL;
+	ps_sw_rotspritememory.value.i = (INT32)(rotspritebytes >> 10);
+}
+
+static patch_t *RotatedPatch_Get(spriteframe_t *sprite, size_t frame, size_t spriteangle, boolean flip, boolean adjustfeet, void *info, INT32 rotationangle, boolean pin)
 {
 	rotsprite_t *rotsprite;
 	spriteinfo_t *sprinfo = (spriteinfo_t *)info;
@@ -833,6 +964,15 @@ patch_t *Patch_GetRotatedSprite(spriteframe_t *sprite, size_t frame, size_t spri
 		if (lump == LUMPERROR)
 			return NULL;
 
+		if (!RotatedPatch_CanRotate() && !pin)
+		{
+			patch = RotatedPatch_Nearest(rotsprite, idx);
+			if (patch)
+				return patch;
+		}
+		rotationsthisframe++;
+		ps_sw_numrotations.value.i++;
+
 		patch = (patch_t *)W_CacheLumpNum(lump, PU_STATIC);
 
 		if (sprinfo->available)
@@ -854,16 +994,40 @@ patch_t *Patch_GetRotatedSprite(spriteframe_t *sprite, size_t frame, size_t spri
 
 		// free image data
 		Z_Free(patch);
+
+		RotatedPatch_Trim();
 	}
+	else if (rotsprite->slots[idx].patch && rotsprite->slots[idx].lastused != framecount)
+		RotatedPatch_Touch(&rotsprite->slots[idx]);
+
+	if (pin)
+		RotatedPatch_Pin(&rotsprite->slots[idx]);
 
 	return rotsprite->patches[idx];
 }
 
+patch_t *Patch_GetRotatedSprite(spriteframe_t *sprite, size_t frame, size_t spriteangle, boolean flip, boolean adjustfeet, void *info, INT32 rotationangle)
+{
+	return RotatedPatch_Get(sprite, frame, spriteangle, flip, adjustfeet, info, rotationangle, false);
+}
+
+//
+// Patch_GetPinnedRotatedSprite
+//
+// Same as Patch_GetRotatedSprite, but the patch is never freed, for callers
+// that keep it around past the current frame.
+//
+patch_t *Patch_GetPinnedRotatedSprite(spriteframe_t *sprite, size_t frame, size_t spriteangle, boolean flip, boolean adjustfeet, void *info, INT32 rotationangle)
+{
+	return RotatedPatch_Get(sprite, frame, spriteangle, flip, adjustfeet, info, rotationangle, true);
+}
+
 rotsprite_t *RotatedPatch_Create(INT32 numangles)
 {
 	rotsprite_t *rotsprite = Z_Calloc(sizeof(rotsprite_t), PU_STATIC, NULL);
 	rotsprite->angles = numangles;
 	rotsprite->patches = Z_Calloc(rotsprite->angles * 2 * sizeof(void *), PU_STATIC, NULL);
+	rotsprite->slots = Z_Calloc(rotsprite->angles * 2 * sizeof(rotspriteslot_t), PU_STATIC, NULL);
 	return rotsprite;
 }
 
@@ -1028,8 +1192,18 @@ void RotatedPatch_DoRotation(rotsprite_t *rotsprite, patch_t *patch, INT32 angle
 		Z_SetUser(hwpatch, (void **)(&rotsprite->patches[idx]));
 	else
 #endif
+	{
+		rotspriteslot_t *slot = &rotsprite->slots[idx];
+
 		Z_SetUser(rotated, (void **)(&rotsprite->patches[idx]));
 
+		slot->patch = &rotsprite->patches[idx];
+		slot->size = size;
+		slot->lastused = framecount;
+		rotspritebytes += size;
+		RotatedPatch_Link(slot);
+	}
+
 	Z_Free(rawconv);
 
 	rotated->leftoffset = ox;
@@ -29,6 +29,8 @@
 #include "p_tick.h"
 #include "r_fps.h"
 #include "r_portal.h"
+#include "i_system.h"
+#include "i_threads.h"
 
 //
 // opening
@@ -52,8 +54,28 @@ visffloor_t ffloor[MAXFFLOORS];
 INT32 numffloors;
 
 //SoM: 3/23/2000: Boom visplane hashing routine.
-#define visplane_hash(picnum,lightlevel,height) \
-  ((unsigned)((picnum)*3+(lightlevel)+(height)*7) & VISPLANEHASHMASK)
+// Mixes every key R_FindPlane matches planes on, so planes that only differ
+// in offsets, angle, slope or colormap still spread over the buckets.
+static inline unsigned R_VisplaneHash(fixed_t height, INT32 picnum, INT32 lightlevel,
+	fixed_t xoff, fixed_t yoff, angle_t plangle, extracolormap_t *planecolormap,
+	polyobj_t *polyobj, pslope_t *slope)
+{
+	UINT32 hash = (UINT32)picnum * 0x9E3779B1u;
+
+	hash = (hash ^ (UINT32)lightlevel) * 0x85EBCA77u;
+	hash = (hash ^ (UINT32)height) * 0xC2B2AE3Du;
+	hash = (hash ^ (UINT32)xoff) * 0x9E3779B1u;
+	hash = (hash ^ (UINT32)yoff) * 0x85EBCA77u;
+	hash = (hash ^ (UINT32)plangle) * 0xC2B2AE3Du;
+	hash = (hash ^ (UINT32)((size_t)planecolormap >> 4)) * 0x9E3779B1u;
+	hash = (hash ^ (UINT32)((size_t)polyobj >> 4)) * 0x85EBCA77u;
+	hash = (hash ^ (UINT32)((size_t)slope >> 4)) * 0xC2B2AE3Du;
+
+	return (hash ^ (hash >> 16)) & VISPLANEHASHMASK;
+}
+
+#define R_PlaneHash(pl) R_VisplaneHash((pl)->height, (pl)->picnum, (pl)->lightlevel, \
+	(pl)->xoffs, (pl)->yoffs, (pl)->plangle, (pl)->extra_colormap, (pl)->polyobj, (pl)->slope)
 
 //SoM: 3/23/2000: Use boom opening limit removal
 size_t maxopenings;
@@ -96,7 +118,16 @@ fixed_t cacheddistance[MAXVIDHEIGHT];
 fixed_t cachedxstep[MAXVIDHEIGHT];
 fixed_t cachedystep[MAXVIDHEIGHT];
 
+// Per-row setup for the plane being drawn, so every span after the first
+// one on a row skips straight to the drawer
+static UINT32 planegeneration; // bumped for every plane R_DrawSinglePlane maps
+static UINT32 cachedplane[MAXVIDHEIGHT];
+static fixed_t cachedxfrac[MAXVIDHEIGHT];
+static fixed_t cachedyfrac[MAXVIDHEIGHT];
+static lighttable_t *cachedcolormap[MAXVIDHEIGHT];
+
 static fixed_t xoffs, yoffs;
+static fixed_t planecos, planesin; // of the current plane's angle
 
 //
 // R_InitPlanes
@@ -148,6 +179,229 @@ static void R_UpdatePlaneRipple(void)
 }
 #endif
 
+#ifdef HAVE_THREADS
+//
+// Threaded plane drawing
+//
+// R_DrawPlanes can queue the spans of plain planes instead of drawing them,
+// sorting them into bands of rows, one per thread. Each thread then draws its
+// own bands in queue order. A row never crosses bands, so every pixel gets
+// written in the same order as when drawing in place.
+// Sky and sloped planes are drawn in place, after flushing the queues.
+//
+#define PLANEBANDSHIFT 3 // 8 rows per band
+
+typedef struct
+{
+	void (*func)(void);
+	UINT8 *source;
+	lighttable_t *colormap;
+	fixed_t xfrac, yfrac, xstep, ystep;
+	INT32 y, x1, x2;
+	UINT32 flatmask, flatxshift, flatyshift, flatshiftup;
+} planespan_t;
+
+typedef struct
+{
+	planespan_t *spans;
+	size_t numspans, maxspans;
+} planequeue_t;
+
+static planequeue_t planequeues[MAXRENDERTHREADS];
+static INT32 numplanethreads; // threads drawing the current R_DrawPlanes, 0 when drawing in place
+static size_t numqueuedspans;
+static boolean queuespans; // current plane's spans get queued
+
+static I_mutex planethread_mutex;
+static I_cond planethread_cond; // workers wait here for spans
+static I_cond planethread_donecond; // and R_FlushPlaneSpans waits here for them
+static UINT32 planethread_generation;
+static INT32 planethread_pending;
+static INT32 planethread_spawned;
+static INT32 planethread_running; // workers that haven't returned yet
+static boolean planethread_quit;
+
+typedef struct
+{
+	INT32 id;
+	UINT32 generation; // the flush before it was spawned, which it isn't part of
+} planethreadarg_t;
+
+static planethreadarg_t planethreadargs[MAXRENDERTHREADS];
+
+static void R_DrawPlaneQueue(planequeue_t *queue)
+{
+	const planespan_t *span = queue->spans;
+	const planespan_t *end = span + queue->numspans;
+
+	for (; span < end; span++)
+	{
+		ds_source = span->source;
+		ds_colormap = span->colormap;
+		ds_xfrac = span->xfrac;
+		ds_yfrac = span->yfrac;
+		ds_xstep = span->xstep;
+		ds_ystep = span->ystep;
+		ds_y = span->y;
+		ds_x1 = span->x1;
+		ds_x2 = span->x2;
+		nflatmask = span->flatmask;
+		nflatxshift = span->flatxshift;
+		nflatyshift = span->flatyshift;
+		nflatshiftup = span->flatshiftup;
+		span->func();
+	}
+
+	queue->numspans = 0;
+}
+
+static void R_PlaneThread(void *userdata)
+{
+	const planethreadarg_t *arg = userdata;
+	const INT32 id = arg->id;
+	UINT32 generation = arg->generation;
+	boolean draw;
+
+	for (;;)
+	{
+		I_lock_mutex(&planethread_mutex);
+		while (planethread_generation == generation && !planethread_quit)
+			I_hold_cond(&planethread_cond, planethread_mutex);
+
+		if (planethread_quit)
+		{
+			if (--planethread_running == 0)
+				I_wake_all_cond(&planethread_donecond);
+			I_unlock_mutex(planethread_mutex);
+			return;
+		}
+
+		generation = planethread_generation;
+		draw = (id < numplanethreads);
+		I_unlock_mutex(planethread_mutex);
+
+		if (draw)
+			R_DrawPlaneQueue(&planequeues[id]);
+
+		I_lock_mutex(&planethread_mutex);
+		if (--planethread_pending == 0)
+			I_wake_all_cond(&planethread_donecond);
+		I_unlock_mutex(planethread_mutex);
+	}
+}
+
+static void R_StopPlaneThreads(void)
+{
+	I_lock_mutex(&planethread_mutex);
+	planethread_quit = true;
+	I_wake_all_cond(&planethread_cond);
+
+	// The span queues and drawers go away after this, so wait for them.
+	while (planethread_running)
+		I_hold_cond(&planethread_donecond, planethread_mutex);
+	I_unlock_mutex(planethread_mutex);
+}
+
+static void R_StartPlaneThreads(INT32 count)
+{
+	if (!planethread_spawned)
+		I_AddExitFunc(R_StopPlaneThreads);
+
+	// Threads stay around once started; extra ones just skip their turn.
+	// A new one has to wait for the next flush, not run on the spans still
+	// being queued.
+	I_lock_mutex(&planethread_mutex);
+	for (; planethread_spawned < count-1; planethread_spawned++)
+	{
+		planethreadarg_t *arg = &planethreadargs[planethread_spawned+1];
+		arg->id = planethread_spawned+1;
+		arg->generation = planethread_generation;
+		planethread_running++;
+		I_spawn_thread("plane-drawer", R_PlaneThread, arg);
+	}
+	I_unlock_mutex(planethread_mutex);
+}
+
+static void R_QueuePlaneSpan(void)
+{
+	planequeue_t *queue = &planequeues[(ds_y >> PLANEBANDSHIFT) % numplanethreads];
+	planespan_t *span;
+
+	if (queue->numspans >= queue->maxspans)
+	{
+		queue->maxspans = queue->maxspans ? queue->maxspans*2 : 1024;
+		queue->spans = Z_Realloc(queue->spans, queue->maxspans * sizeof (*queue->spans), PU_STATIC, NULL);
+	}
+
+	span = &queue->spans[queue->numspans++];
+	span->func = spanfunc;
+	span->source = ds_source;
+	span->colormap = ds_colormap;
+	span->xfrac = ds_xfrac;
+	span->yfrac = ds_yfrac;
+	span->xstep = ds_xstep;
+	span->ystep = ds_ystep;
+	span->y = ds_y;
+	span->x1 = ds_x1;
+	span->x2 = ds_x2;
+	span->flatmask = nflatmask;
+	span->flatxshift = nflatxshift;
+	span->flatyshift = nflatyshift;
+	span->flatshiftup = nflatshiftup;
+	numqueuedspans++;
+}
+
+// Draws everything queued so far, on every thread, and waits for them.
+static void R_FlushPlaneSpans(void)
+{
+	if (!numqueuedspans)
+		return;
+
+	I_lock_mutex(&planethread_mutex);
+	planethread_pending = planethread_spawned;
+	planethread_generation++;
+	I_wake_all_cond(&planethread_cond);
+	I_unlock_mutex(planethread_mutex);
+
+	R_DrawPlaneQueue(&planequeues[0]);
+
+	I_lock_mutex(&planethread_mutex);
+	while (planethread_pending)
+		I_hold_cond(&planethread_donecond, planethread_mutex);
+	I_unlock_mutex(planethread_mutex);
+
+	numqueuedspans = 0;
+}
+#endif
+
+// Sets up R_MapPlane for the spans of currentplane
+static void R_StartPlaneSpans(void)
+{
+	const angle_t angle = (currentplane->viewangle + currentplane->plangle)>>ANGLETOFINESHIFT;
+
+	planecos = FINECOSINE(angle);
+	planesin = FINESINE(angle);
+
+	// Forget the rows of the last plane
+	if (++planegeneration == 0)
+	{
+		memset(cachedplane, 0, sizeof (cachedplane));
+		planegeneration = 1;
+	}
+}
+
+// The current plane's colormap for the given light level
+static inline lighttable_t *R_PlaneColormap(lighttable_t *colormap)
+{
+	if (encoremap && !currentplane->noencore)
+		colormap += COLORMAP_REMAPOFFSET;
+
+	if (currentplane->extra_colormap)
+		colormap = currentplane->extra_colormap->colormap + (colormap - colormaps);
+
+	return colormap;
+}
+
 //
 // R_MapPlane
 //
@@ -162,8 +416,7 @@ static void R_UpdatePlaneRipple(void)
 //  viewheight
 void R_MapPlane(INT32 y, INT32 x1, INT32 x2)
 {
-	angle_t angle, planecos, planesin;
-	fixed_t distance = 0, span;
+	fixed_t distance, span;
 	size_t pindex;
 
 #ifdef RANGECHECK
@@ -176,40 +429,56 @@ void R_MapPlane(INT32 y, INT32 x1, INT32 x2)
 
 	if (!currentplane->slope)
 	{
-		angle = (currentplane->viewangle + currentplane->plangle)>>ANGLETOFINESHIFT;
-		planecos = FINECOSINE(angle);
-		planesin = FINESINE(angle);
-
-		if (planeheight != cachedheight[y])
+		if (cachedplane[y] != planegeneration) // first span of this plane on this row
 		{
-			cachedheight[y] = planeheight;
-			cacheddistance[y] = distance = FixedMul(planeheight, yslope[y]);
-			span = abs(centery - y);
-
-			if (span) // don't divide by zero
+			if (planeheight != cachedheight[y])
 			{
-				ds_xstep = FixedMul(planesin, planeheight) / span;
-				ds_ystep = FixedMul(planecos, planeheight) / span;
+				cachedheight[y] = planeheight;
+				cacheddistance[y] = distance = FixedMul(planeheight, yslope[y]);
+				span = abs(centery - y);
+
+				if (span) // don't divide by zero
+				{
+					ds_xstep = FixedMul(planesin, planeheight) / span;
+					ds_ystep = FixedMul(planecos, planeheight) / span;
+				}
+				else
+				{
+					ds_xstep = FixedMul(distance, basexscale);
+					ds_ystep = FixedMul(distance, baseyscale);
+				}
+
+				cachedxstep[y] = ds_xstep;
+				cachedystep[y] = ds_ystep;
 			}
 			else
 			{
-				ds_xstep = FixedMul(distance, basexscale);
-				ds_ystep = FixedMul(distance, baseyscale);
+				distance = cacheddistance[y];
+				ds_xstep = cachedxstep[y];
+				ds_ystep = cachedystep[y];
 			}
 
-			cachedxstep[y] = ds_xstep;
-			cachedystep[y] = ds_ystep;
+			pindex = distance >> LIGHTZSHIFT;
+			if (pindex >= MAXLIGHTZ)
+				pindex = MAXLIGHTZ - 1;
+
+			cachedplane[y] = planegeneration;
+			cachedxfrac[y] = xoffs + FixedMul(planecos, distance) - centerx * ds_xstep;
+			cachedyfrac[y] = yoffs - FixedMul(planesin, distance) - centerx * ds_ystep;
+			cachedcolormap[y] = R_PlaneColormap(planezlight[pindex]);
 		}
 		else
 		{
-			distance = cacheddistance[y];
 			ds_xstep = cachedxstep[y];
 			ds_ystep = cachedystep[y];
 		}
 
-		ds_xfrac = xoffs + FixedMul(planecos, distance) + (x1 - centerx) * ds_xstep;
-		ds_yfrac = yoffs - FixedMul(planesin, distance) + (x1 - centerx) * ds_ystep;
+		ds_xfrac = cachedxfrac[y] + x1 * ds_xstep;
+		ds_yfrac = cachedyfrac[y] + x1 * ds_ystep;
+		ds_colormap = cachedcolormap[y];
 	}
+	else
+		ds_colormap = R_PlaneColormap(colormaps);
 
 #ifndef NOWATER
 	if (planeripple.active)
@@ -236,25 +505,21 @@ void R_MapPlane(INT32 y, INT32 x1, INT32 x2)
 	}
 #endif
 
-	if (currentplane->slope)
-		ds_colormap = colormaps;
-	else
-	{
-		pindex = distance >> LIGHTZSHIFT;
-		if (pindex >= MAXLIGHTZ)
-			pindex = MAXLIGHTZ - 1;
-		ds_colormap = planezlight[pindex];
-	}
-	if (encoremap && !currentplane->noencore)
-		ds_colormap += COLORMAP_REMAPOFFSET;
-
-	if (currentplane->extra_colormap)
-		ds_colormap = currentplane->extra_colormap->colormap + (ds_colormap - colormaps);
-
 	ds_y = y;
 	ds_x1 = x1;
 	ds_x2 = x2;
 
+	ps_sw_numplanespans.value.i++;
+	ps_sw_planepixels.value.i += x2 - x1 + 1;
+
+#ifdef HAVE_THREADS
+	if (queuespans)
+	{
+		R_QueuePlaneSpan();
+		return;
+	}
+#endif
+
 	spanfunc();
 }
 
@@ -337,6 +602,7 @@ static visplane_t *new_visplane(unsigned hash)
 	}
 	check->next = visplanes[hash];
 	visplanes[hash] = check;
+	ps_sw_numvisplanes.value.i++;
 	return check;
 }
 
@@ -401,7 +667,7 @@ visplane_t *R_FindPlane(fixed_t height, INT32 picnum, INT32 lightlevel,
 
 	if (!pfloor)
 	{
-		hash = visplane_hash(picnum, lightlevel, height);
+		hash = R_VisplaneHash(height, picnum, lightlevel, xoff, yoff, plangle, planecolormap, polyobj, slope);
 		for (check = visplanes[hash]; check; check = check->next)
 		{
 			if (polyobj != check->polyobj)
@@ -451,46 +717,45 @@ visplane_t *R_FindPlane(fixed_t height, INT32 picnum, INT32 lightlevel,
 	return check;
 }
 
-//
-// R_CheckPlane: return same visplane or alloc a new one if needed
-//
-visplane_t *R_CheckPlane(visplane_t *pl, INT32 start, INT32 stop)
+// Can columns start to stop of this plane still be drawn into?
+static boolean R_PlaneHasRoom(const visplane_t *pl, INT32 start, INT32 stop)
 {
-	INT32 intrl, intrh;
-	INT32 unionl, unionh;
-	INT32 x;
-
-	if (start < pl->minx)
-	{
-		intrl = pl->minx;
-		unionl = start;
-	}
-	else
-	{
-		unionl = pl->minx;
-		intrl = start;
-	}
-
-	if (stop > pl->maxx)
-	{
-		intrh = pl->maxx;
-		unionh = stop;
-	}
-	else
-	{
-		unionh = pl->maxx;
-		intrh = stop;
-	}
+	INT32 x = max(start, pl->minx);
+	const INT32 intrh = min(stop, pl->maxx);
 
 	// 0xff is not equal to -1 with shorts...
-	for (x = intrl; x <= intrh; x++)
+	for (; x <= intrh; x++)
 		if (pl->top[x] != 0xffff || pl->bottom[x] != 0x0000)
-			break;
+			return false;
+
+	return true;
+}
 
-	if (x > intrh) /* Can use existing plane; extend range */
+// Would these two planes draw the same spans?
+static boolean R_SamePlane(const visplane_t *a, const visplane_t *b)
+{
+	return (a->height == b->height && a->picnum == b->picnum
+		&& a->lightlevel == b->lightlevel
+		&& a->xoffs == b->xoffs && a->yoffs == b->yoffs
+		&& a->extra_colormap == b->extra_colormap
+		&& a->viewx == b->viewx && a->viewy == b->viewy && a->viewz == b->viewz
+		&& a->viewangle == b->viewangle
+		&& a->plangle == b->plangle
+		&& a->ffloor == b->ffloor
+		&& a->polyobj == b->polyobj
+		&& a->slope == b->slope
+		&& a->noencore == b->noencore);
+}
+
+//
+// R_CheckPlane: return same visplane or alloc a new one if needed
+//
+visplane_t *R_CheckPlane(visplane_t *pl, INT32 start, INT32 stop)
+{
+	if (R_PlaneHasRoom(pl, start, stop)) /* Can use existing plane; extend range */
 	{
-		pl->minx = unionl;
-		pl->maxx = unionh;
+		pl->minx = min(start, pl->minx);
+		pl->maxx = max(stop, pl->maxx);
 	}
 	else /* Cannot use existing plane; create a new one */
 	{
@@ -501,7 +766,23 @@ visplane_t *R_CheckPlane(visplane_t *pl, INT32 start, INT32 stop)
 		}
 		else
 		{
-			unsigned hash = visplane_hash(pl->picnum, pl->lightlevel, pl->height);
+			unsigned hash = R_PlaneHash(pl);
+
+			// Another plane split off from this one earlier may still have room.
+			// Polyobject planes are tracked by their polyobject, so leave them be.
+			if (!pl->polyobj)
+			{
+				for (new_pl = visplanes[hash]; new_pl; new_pl = new_pl->next)
+				{
+					if (new_pl != pl && R_SamePlane(new_pl, pl) && R_PlaneHasRoom(new_pl, start, stop))
+					{
+						new_pl->minx = min(start, new_pl->minx);
+						new_pl->maxx = max(stop, new_pl->maxx);
+						return new_pl;
+					}
+				}
+			}
+
 			new_pl = new_visplane(hash);
 		}
 
@@ -529,7 +810,6 @@ visplane_t *R_CheckPlane(visplane_t *pl, INT32 start, INT32 stop)
 	return pl;
 }
 
-
 //
 // R_ExpandPlane
 //
@@ -612,6 +892,12 @@ void R_DrawPlanes(void)
 	spanfunc = basespanfunc;
 	wallcolfunc = walldrawerfunc;
 
+#ifdef HAVE_THREADS
+	numplanethreads = (cv_renderthreads.value > 1) ? cv_renderthreads.value : 0;
+	if (numplanethreads)
+		R_StartPlaneThreads(numplanethreads);
+#endif
+
 	for (i = 0; i < MAXVISPLANES; i++, pl++)
 	{
 		for (pl = visplanes[i]; pl; pl = pl->next)
@@ -619,9 +905,24 @@ void R_DrawPlanes(void)
 			if (pl->ffloor != NULL || pl->polyobj != NULL)
 				continue;
 
+#ifdef HAVE_THREADS
+			if (numplanethreads)
+			{
+				queuespans = (pl->picnum != skyflatnum && !pl->slope);
+				if (!queuespans)
+					R_FlushPlaneSpans();
+			}
+#endif
+
 			R_DrawSinglePlane(pl);
 		}
 	}
+
+#ifdef HAVE_THREADS
+	R_FlushPlaneSpans();
+	queuespans = false;
+	numplanethreads = 0;
+#endif
 	
 #ifndef NOWATER
 	R_UpdatePlaneRipple();
@@ -790,7 +1091,7 @@ void R_DrawSinglePlane(visplane_t *pl)
 
 	if (pl->polyobj && pl->polyobj->translucency != 0)
 	{
-		spanfunc = R_DrawTranslucentSpan_8;
+		spanfunc = transspanfunc;
 
 		// Hacked up support for alpha value in software mode Tails 09-24-2002 (sidenote: ported to polys 10-15-2014, there was no time travel involved -Red)
 		if (pl->polyobj->translucency >= 10)
@@ -830,7 +1131,7 @@ void R_DrawSinglePlane(visplane_t *pl)
 
 			if (pl->ffloor->flags & FF_TRANSLUCENT)
 			{
-				spanfunc = R_DrawTranslucentSpan_8;
+				spanfunc = transspanfunc;
 
 				// Hacked up support for alpha value in software mode Tails 09-24-2002
 				if (pl->ffloor->alpha < 12)
@@ -882,7 +1183,7 @@ void R_DrawSinglePlane(visplane_t *pl)
 				{
 					planeripple.active = true;
 
-					if (spanfunc == R_DrawTranslucentSpan_8)
+					if (spanfunc == transspanfunc)
 					{
 						spanfunc = R_DrawTranslucentWaterSpan_8;
 
@@ -1072,15 +1373,15 @@ void R_DrawSinglePlane(visplane_t *pl)
 
 #ifndef NOWATER
 		if (spanfunc == R_DrawTranslucentWaterSpan_8)
-			spanfunc = R_DrawTiltedTranslucentWaterSpan_8;
+			spanfunc = tiltedwaterspanfunc;
 		else
 #endif
-		if (spanfunc == R_DrawTranslucentSpan_8)
-			spanfunc = R_DrawTiltedTranslucentSpan_8;
+		if (spanfunc == transspanfunc)
+			spanfunc = tiltedtransspanfunc;
 		else if (spanfunc == splatfunc)
-			spanfunc = R_DrawTiltedSplat_8;
+			spanfunc = tiltedsplatfunc;
 		else
-			spanfunc = R_DrawTiltedSpan_8;
+			spanfunc = tiltedspanfunc;
 
 		planezlight = scalelight[light];
 	}
@@ -1103,6 +1404,8 @@ void R_DrawSinglePlane(visplane_t *pl)
 	if (viewz != pl->viewz)
 		viewz = pl->viewz;
 
+	R_StartPlaneSpans();
+
 	for (x = pl->minx; x <= stop; x++)
 	{
 		R_MakeSpans(x, pl->top[x-1], pl->bottom[x-1],
@@ -1126,11 +1429,11 @@ a 'smoothing' of the texture while
 using the palette colors.
 */
 #ifdef QUINCUNX
-	if (spanfunc == R_DrawSpan_8)
+	if (spanfunc == basespanfunc)
 	{
 		INT32 i;
 		ds_transmap = transtables + ((tr_trans50-1)<<FF_TRANSSHIFT);
-		spanfunc = R_DrawTranslucentSpan_8;
+		spanfunc = transspanfunc;
 		for (i=0; i<4; i++)
 		{
 			xoffs = pl->xoffs;
@@ -1173,6 +1476,8 @@ using the palette colors.
 
 			stop = pl->maxx + 1;
 
+			R_StartPlaneSpans();
+
 			for (x = pl->minx; x <= stop; x++)
 				R_MakeSpans(x, pl->top[x-1], pl->bottom[x-1],
 					pl->top[x], pl->bottom[x]);
@@ -19,7 +19,7 @@
 #include "p_polyobj.h"
 
 //SoM: 3/23/2000: Use Boom visplane hashing.
-#define VISPLANEHASHBITS 9
+#define VISPLANEHASHBITS 10
 #define VISPLANEHASHMASK ((1<<VISPLANEHASHBITS)-1)
 // the last visplane list is outside of the hash table and is used for fof planes
 #define MAXVISPLANES ((1<<VISPLANEHASHBITS)+1)
@@ -89,24 +89,34 @@ static const char *spritename;
 // Unfortunately, SRB2's drawing loop has lots of annoying
 // changes from Doom for portals, which make it hard to implement.
 
+//
+// Rather than prboom-plus's three x-ranges, the screen is cut into up to
+// DS_MAXTILES tiles of columns, and every clipping drawseg is listed in each
+// tile it covers, latest first. A sprite then only walks the tiles it covers,
+// clipping the columns of each tile in the same order as walking all drawsegs.
+// Whether a drawseg clips the current sprite at all is worked out once per
+// sprite, and remembered for the other tiles it shows up in.
+
 typedef struct drawseg_xrange_item_s
 {
 	INT16 x1, x2;
 	drawseg_t *user;
 } drawseg_xrange_item_t;
 
-typedef struct drawsegs_xrange_s
-{
-	drawseg_xrange_item_t *items;
-	INT32 count;
-} drawsegs_xrange_t;
+#define DS_MAXTILES 64
+#define DS_MINTILESHIFT 3 // no narrower than 8 columns
 
-#define DS_RANGES_COUNT 3
-static drawsegs_xrange_t drawsegs_xranges[DS_RANGES_COUNT];
+static drawseg_xrange_item_t *drawsegs_tileitems;
+static size_t drawsegs_tileitems_size = 0;
+static INT32 drawsegs_tilestart[DS_MAXTILES+1]; // tile t is tileitems[tilestart[t]] to tileitems[tilestart[t+1]-1]
+static INT32 drawsegs_tilecount = 0;
+static INT32 drawsegs_tileshift;
 
-static drawseg_xrange_item_t *drawsegs_xrange;
-static size_t drawsegs_xrange_size = 0;
-static INT32 drawsegs_xrange_count = 0;
+// per drawseg: the sprite it was last tested against, and its silhouette for it
+static UINT32 *drawsegs_clipstamp;
+static INT32 *drawsegs_clipsil;
+static size_t drawsegs_clip_size = 0;
+static UINT32 drawsegs_curstamp;
 
 // ==========================================================================
 //
@@ -1112,14 +1122,14 @@ fixed_t R_GetShadowZ(mobj_t *thing, pslope_t **shadowslope)
 // R_ProjectSprite
 // Generates a vissprite for a thing
 // if it might be visible.
+// Only called for things that survived R_CullProjectionBatch,
+// given their interpolated state and view transform from there.
 //
-static void R_ProjectSprite(mobj_t *thing)
+static void R_ProjectSprite(mobj_t *thing, const interpmobjstate_t *interp, fixed_t tr_x, fixed_t tr_y, fixed_t tz, fixed_t tx)
 {
 	mobj_t *oldthing = thing;
 
-	fixed_t tr_x, tr_y;
 	fixed_t gxt, gyt;
-	fixed_t tx, tz;
 	fixed_t xscale, yscale, sortscale; //added : 02-02-98 : aaargll..if I were a math-guy!!!
 
 	INT32 x1, x2;
@@ -1168,46 +1178,7 @@ static void R_ProjectSprite(mobj_t *thing)
 	angle_t sliptiderollangle = 0;
 #endif
 
-	INT32 dist = -1;
-
-	if (cv_maxinterpdist.value)
-		dist = R_QuickCamDist(thing->x, thing->y);
-
-	// uncapped/interpolation
-	interpmobjstate_t interp = {0};
-
-	// do interpolation
-	if (R_UsingFrameInterpolation() && !paused && (!cv_maxinterpdist.value || dist < cv_maxinterpdist.value))
-	{
-		R_InterpolateMobjState(oldthing, rendertimefrac, &interp);
-	}
-	else
-	{
-		R_InterpolateMobjState(oldthing, FRACUNIT, &interp);
-	}
-
-	this_scale = interp.scale;
-
-	// transform the origin point
-	tr_x = interp.x - viewx;
-	tr_y = interp.y - viewy;
-
-	gxt = FixedMul(tr_x, viewcos);
-	gyt = -FixedMul(tr_y, viewsin);
-
-	tz = gxt-gyt;
-
-	// thing is behind view plane?
-	if (!papersprite && (tz < FixedMul(MINZ, this_scale))) // papersprite clipping is handled later
-		return;
-
-	gxt = -FixedMul(tr_x, viewsin);
-	gyt = FixedMul(tr_y, viewcos);
-	tx = -(gyt + gxt);
-
-	// too far off the side?
-	if (!papersprite && abs(tx) > tz<<2) // papersprite clipping is handled later
-		return;
+	this_scale = interp->scale;
 
 	// aspect ratio stuff
 	xscale = FixedDiv(projection, tz);
@@ -1267,8 +1238,8 @@ static void R_ProjectSprite(mobj_t *thing)
 
 	if (sprframe->rotate != SRF_SINGLE || papersprite || (cv_sloperoll.value == 2 && cv_spriteroll.value))
 	{
-		ang = R_PointToAngle (interp.x, interp.y) - interp.angle;
-		camang = R_PointToAngle (interp.x, interp.y);
+		ang = R_PointToAngle (interp->x, interp->y) - interp->angle;
+		camang = R_PointToAngle (interp->x, interp->y);
 
 		if (mirrored)
 			ang = InvAngle(ang);
@@ -1284,7 +1255,7 @@ static void R_ProjectSprite(mobj_t *thing)
 	else
 	{
 		// choose a different rotation based on player view
-		//ang = R_PointToAngle (interp.x, interp.y) - interpangle;
+		//ang = R_PointToAngle (interp->x, interp->y) - interpangle;
 
 		if ((sprframe->rotate & SRF_RIGHT) && (ang < ANGLE_180)) // See from right
 			rot = 6; // F7 slot
@@ -1331,10 +1302,10 @@ static void R_ProjectSprite(mobj_t *thing)
 		{
 			// this is very messy, but it on-the-fly calculates rotations for all the
 			// pitch and roll variables
-			pitchnroll = FixedMul(FINECOSINE((ang) >> ANGLETOFINESHIFT), interp.roll) +
-						 FixedMul(FINESINE((ang) >> ANGLETOFINESHIFT), interp.pitch) +
-						 FixedMul(FINECOSINE((camang) >> ANGLETOFINESHIFT), interp.sloperoll) +
-						 FixedMul(FINESINE((camang) >> ANGLETOFINESHIFT), interp.slopepitch);
+			pitchnroll = FixedMul(FINECOSINE((ang) >> ANGLETOFINESHIFT), interp->roll) +
+						 FixedMul(FINESINE((ang) >> ANGLETOFINESHIFT), interp->pitch) +
+						 FixedMul(FINECOSINE((camang) >> ANGLETOFINESHIFT), interp->sloperoll) +
+						 FixedMul(FINESINE((camang) >> ANGLETOFINESHIFT), interp->slopepitch);
 
 			rollangle = thing->rollangle;
 		}
@@ -1374,13 +1345,13 @@ static void R_ProjectSprite(mobj_t *thing)
 	flip = !flip != !hflip;
 
 	// calculate edges of the shape
-	spritexscale = interp.spritexscale;
-	spriteyscale = interp.spriteyscale;
+	spritexscale = interp->spritexscale;
+	spriteyscale = interp->spriteyscale;
 	if (spritexscale < 1 || spriteyscale < 1)
 		return;
 
-	spr_offset += interp.spritexoffset;
-	spr_topoffset += interp.spriteyoffset;
+	spr_offset += interp->spritexoffset;
+	spr_topoffset += interp->spriteyoffset;
 
 	if (flip)
 		offset = spr_offset - spr_width;
@@ -1401,8 +1372,8 @@ static void R_ProjectSprite(mobj_t *thing)
 			offset2 *= -1;
 		}
 
-		cosmul = FINECOSINE(interp.angle >> ANGLETOFINESHIFT);
-		sinmul = FINESINE(interp.angle >> ANGLETOFINESHIFT);
+		cosmul = FINECOSINE(interp->angle >> ANGLETOFINESHIFT);
+		sinmul = FINESINE(interp->angle >> ANGLETOFINESHIFT);
 
 		tr_x += FixedMul(offset, cosmul);
 		tr_y += FixedMul(offset, sinmul);
@@ -1425,7 +1396,7 @@ static void R_ProjectSprite(mobj_t *thing)
 			paperoffset = -paperoffset;
 			paperdistance = -paperdistance;
 		}
-		centerangle = viewangle - interp.angle;
+		centerangle = viewangle - interp->angle;
 
 		tr_x += FixedMul(offset2, cosmul);
 		tr_y += FixedMul(offset2, sinmul);
@@ -1531,7 +1502,7 @@ static void R_ProjectSprite(mobj_t *thing)
 		if (x2 < portalclipstart || x1 >= portalclipend)
 			return;
 
-		if (P_PointOnLineSide(interp.x, interp.y, portalclipline) != 0)
+		if (P_PointOnLineSide(interp->x, interp->y, portalclipline) != 0)
 			return;
 	}
 
@@ -1541,12 +1512,12 @@ static void R_ProjectSprite(mobj_t *thing)
 		// When vertical flipped, draw sprites from the top down, at least as far as offsets are concerned.
 		// sprite height - sprite topoffset is the proper inverse of the vertical offset, of course.
 		// remember gz and gzt should be seperated by sprite height, not thing height - thing height can be shorter than the sprite itself sometimes!
-		gz = interp.z + oldthing->height - FixedMul(spr_topoffset, FixedMul(spriteyscale, this_scale));
+		gz = interp->z + oldthing->height - FixedMul(spr_topoffset, FixedMul(spriteyscale, this_scale));
 		gzt = gz + FixedMul(spr_height, FixedMul(spriteyscale, this_scale));
 	}
 	else
 	{
-		gzt = interp.z + FixedMul(spr_topoffset, FixedMul(spriteyscale, this_scale));
+		gzt = interp->z + FixedMul(spr_topoffset, FixedMul(spriteyscale, this_scale));
 		gz = gzt - FixedMul(spr_height, FixedMul(spriteyscale, this_scale));
 	}
 
@@ -1562,7 +1533,7 @@ static void R_ProjectSprite(mobj_t *thing)
 		light = thing->subsector->sector->numlights - 1;
 
 		for (lightnum = 1; lightnum < thing->subsector->sector->numlights; lightnum++) {
-			fixed_t h = thing->subsector->sector->lightlist[lightnum].slope ? P_GetZAt(thing->subsector->sector->lightlist[lightnum].slope, interp.x, interp.y)
+			fixed_t h = thing->subsector->sector->lightlist[lightnum].slope ? P_GetZAt(thing->subsector->sector->lightlist[lightnum].slope, interp->x, interp->y)
 			            : thing->subsector->sector->lightlist[lightnum].height;
 			if (h <= gzt)
 			{
@@ -1589,12 +1560,12 @@ static void R_ProjectSprite(mobj_t *thing)
 	if (heightsec != -1 && phs != -1) // only clip things which are in special sectors
 	{
 		if (viewz < sectors[phs].floorheight ?
-		interp.z >= sectors[heightsec].floorheight :
+		interp->z >= sectors[heightsec].floorheight :
 		gzt < sectors[heightsec].floorheight)
 			return;
 		if (viewz > sectors[phs].ceilingheight ?
 		gzt < sectors[heightsec].ceilingheight && viewz >= sectors[heightsec].ceilingheight :
-		interp.z >= sectors[heightsec].ceilingheight)
+		interp->z >= sectors[heightsec].ceilingheight)
 			return;
 	}
 
@@ -1605,12 +1576,12 @@ static void R_ProjectSprite(mobj_t *thing)
 	vis->scale = yscale; //<<detailshift;
 	vis->sortscale = sortscale;
 	vis->dispoffset = thing->info->dispoffset; // Monster Iestyn: 23/11/15
-	vis->gx = interp.x;
-	vis->gy = interp.y;
+	vis->gx = interp->x;
+	vis->gy = interp->y;
 	vis->gz = gz;
 	vis->gzt = gzt;
 	vis->thingheight = thing->height;
-	vis->pz = interp.z;
+	vis->pz = interp->z;
 	vis->pzt = vis->pz + vis->thingheight;
 	vis->texturemid = FixedDiv(gzt - viewz, spriteyscale);
 	vis->scalestep = scalestep;
@@ -1635,7 +1606,7 @@ static void R_ProjectSprite(mobj_t *thing)
 
 	vis->xscale = FixedMul(spritexscale, xscale); //SoM: 4/17/2000
 	vis->scale = FixedMul(spriteyscale, yscale); //<<detailshift;
-	vis->thingscale = interp.scale;
+	vis->thingscale = interp->scale;
 
 	vis->spritexscale = spritexscale;
 	vis->spriteyscale = spriteyscale;
@@ -1745,12 +1716,6 @@ static void R_ProjectPrecipitationSprite(precipmobj_t *thing)
 	// uncapped/interpolation
 	interpmobjstate_t interp = {0};
 
-	// okay... this is a hack, but weather isn't networked, so it should be ok
-	if (!P_PrecipThinker(thing))
-	{
-		return;
-	}
-
 	// do interpolation
 	if (R_UsingFrameInterpolation() && !paused && (!cv_maxinterpdist.value || dist < cv_maxinterpdist.value))
 	{
@@ -1903,6 +1868,85 @@ static void R_ProjectPrecipitationSprite(precipmobj_t *thing)
 	vis->isScaled = false;
 }
 
+//
+// Sprite projection batch
+//
+// R_AddSprites projects the things of a sector in passes. The things worth
+// looking at get gathered first, then interpolated, then all of them get
+// transformed to view space and culled at once in R_CullProjectionBatch,
+// a loop over plain arrays without branches that the compiler can vectorize.
+// Only the survivors go on to have their frames and patches looked up.
+//
+static mobj_t **projthings;
+static interpmobjstate_t *projinterp;
+static fixed_t *projtrx, *projtry; // origin relative to the view
+static fixed_t *projminz; // closest tz the thing can be drawn at
+static fixed_t *projtz, *projtx; // view space origin
+static UINT8 *projpaper, *projkeep;
+static size_t numprojthings, maxprojthings;
+
+static void R_GrowProjectionBatch(void)
+{
+	maxprojthings = maxprojthings ? maxprojthings*2 : 128;
+	projthings = Z_Realloc(projthings, maxprojthings * sizeof (*projthings), PU_STATIC, NULL);
+	projinterp = Z_Realloc(projinterp, maxprojthings * sizeof (*projinterp), PU_STATIC, NULL);
+	projtrx = Z_Realloc(projtrx, maxprojthings * sizeof (*projtrx), PU_STATIC, NULL);
+	projtry = Z_Realloc(projtry, maxprojthings * sizeof (*projtry), PU_STATIC, NULL);
+	projminz = Z_Realloc(projminz, maxprojthings * sizeof (*projminz), PU_STATIC, NULL);
+	projtz = Z_Realloc(projtz, maxprojthings * sizeof (*projtz), PU_STATIC, NULL);
+	projtx = Z_Realloc(projtx, maxprojthings * sizeof (*projtx), PU_STATIC, NULL);
+	projpaper = Z_Realloc(projpaper, maxprojthings * sizeof (*projpaper), PU_STATIC, NULL);
+	projkeep = Z_Realloc(projkeep, maxprojthings * sizeof (*projkeep), PU_STATIC, NULL);
+}
+
+static void R_InterpolateProjection(size_t i)
+{
+	mobj_t *thing = projthings[i];
+	interpmobjstate_t *interp = &projinterp[i];
+	INT32 dist = -1;
+
+	if (cv_maxinterpdist.value)
+		dist = R_QuickCamDist(thing->x, thing->y);
+
+	memset(interp, 0, sizeof (*interp));
+
+	// do interpolation
+	if (R_UsingFrameInterpolation() && !paused && (!cv_maxinterpdist.value || dist < cv_maxinterpdist.value))
+	{
+		R_InterpolateMobjState(thing, rendertimefrac, interp);
+	}
+	else
+	{
+		R_InterpolateMobjState(thing, FRACUNIT, interp);
+	}
+
+	// transform the origin point
+	projtrx[i] = interp->x - viewx;
+	projtry[i] = interp->y - viewy;
+	projminz[i] = FixedMul(MINZ, interp->scale);
+	projpaper[i] = (thing->frame & FF_PAPERSPRITE) ? 1 : 0;
+}
+
+static void R_CullProjectionBatch(void)
+{
+	const fixed_t vcos = viewcos, vsin = viewsin;
+	fixed_t tz, tx;
+	size_t i;
+
+	for (i = 0; i < numprojthings; i++)
+	{
+		tz = FixedMul(projtrx[i], vcos) + FixedMul(projtry[i], vsin);
+		tx = -(FixedMul(projtry[i], vcos) - FixedMul(projtrx[i], vsin));
+
+		projtz[i] = tz;
+		projtx[i] = tx;
+
+		// thing is behind view plane or too far off the side?
+		// papersprite clipping is handled later
+		projkeep[i] = (UINT8)(projpaper[i] | ((tz >= projminz[i]) & (abs(tx) <= tz<<2)));
+	}
+}
+
 // R_AddSprites
 // During BSP traversal, this adds sprites by sector.
 //
@@ -1910,6 +1954,7 @@ void R_AddSprites(sector_t *sec, INT32 lightlevel)
 {
 	mobj_t *thing;
 	INT32 lightnum;
+	size_t i;
 
 	if (rendermode != render_soft)
 		return;
@@ -1949,8 +1994,27 @@ void R_AddSprites(sector_t *sec, INT32 lightlevel)
 		if (!R_ThingVisible(thing))
 			continue;
 
-		R_ProjectSprite(thing);
+		if (numprojthings >= maxprojthings)
+			R_GrowProjectionBatch();
+
+		projthings[numprojthings++] = thing;
+	}
+
+	if (!numprojthings)
+		return;
+
+	for (i = 0; i < numprojthings; i++)
+		R_InterpolateProjection(i);
+
+	R_CullProjectionBatch();
+
+	for (i = 0; i < numprojthings; i++)
+	{
+		if (projkeep[i])
+			R_ProjectSprite(projthings[i], &projinterp[i], projtrx[i], projtry[i], projtz[i], projtx[i]);
 	}
+
+	numprojthings = 0;
 }
 
 // R_AddPrecipitationSprites
@@ -1962,8 +2026,9 @@ void R_AddPrecipitationSprites(void)
 {
 	fixed_t drawdist = (fixed_t)(cv_drawdist_precip.value) * (cv_mobjscaleprecip.value ? mapobjectscale : FRACUNIT);
 
-	INT32 xl, xh, yl, yh, bx, by;
-	precipmobj_t *th, *next;
+	INT32 xl, xh, yl, yh;
+	precipmobj_t *drops;
+	size_t i, numdrops;
 
 	// no, no infinite draw distance for precipitation. this option at zero is supposed to turn it off
 	if (drawdist == 0 || curWeather == PRECIP_BLANK || curWeather == PRECIP_STORM_NORAIN)
@@ -1973,101 +2038,103 @@ void R_AddPrecipitationSprites(void)
 
 	R_GetRenderBlockMapDimensions(drawdist, &xl, &xh, &yl, &yh);
 
-	for (bx = xl; bx <= xh; bx++)
-	{
-		for (by = yl; by <= yh; by++)
-		{
-			for (th = precipblocklinks[(by * bmapwidth) + bx]; th; th = next)
-			{
-				// Store this beforehand because R_ProjectPrecipitionSprite may free th (see P_PrecipThinker)
-				next = th->bnext;
-
-				if (th->precipflags & PCF_INVISIBLE)
-					continue;
+	numdrops = P_GeneratePrecipitation(xl, xh, yl, yh, &drops);
 
-				R_ProjectPrecipitationSprite(th);
-			}
-		}
-	}
+	for (i = 0; i < numdrops; i++)
+		R_ProjectPrecipitationSprite(&drops[i]);
 }
 
 //
 // R_SortVisSprites
 //
+// Orders the visible vissprites by sortscale, then dispoffset, smallest
+// first. Sprites with equal keys keep the order they were projected in.
+// Both fields are packed into one 64-bit key for a stable LSD radix sort,
+// which skips every byte that is the same across all keys.
+//
 static vissprite_t vsprsortedhead;
 
+typedef struct
+{
+	UINT64 key;
+	vissprite_t *spr;
+} vsprsortkey_t;
+
+static vsprsortkey_t *vsprsortkeys = NULL;
+static vsprsortkey_t *vsprsorttemp = NULL;
+static UINT32 vsprsortsize = 0;
+
 void R_SortVisSprites(void)
 {
-	UINT32       i;
-	vissprite_t *ds, *dsprev, *dsnext, *dsfirst;
-	vissprite_t *best = NULL;
-	vissprite_t  unsorted;
-	fixed_t      bestscale;
-	INT32        bestdispoffset;
+	vsprsortkey_t *src, *dst, *swap;
+	vissprite_t  *ds;
+	UINT32        counts[256];
+	UINT32        i, count, pos, digit;
+	UINT64        differ = 0;
+	INT32         shift;
+
+	vsprsortedhead.next = vsprsortedhead.prev = &vsprsortedhead;
 
 	if (!visspritecount)
 		return;
 
-	unsorted.next = unsorted.prev = &unsorted;
-
-	dsfirst = R_GetVisSprite(0);
+	if (vsprsortsize < visspritecount)
+	{
+		vsprsortsize = visspritecount * 2;
+		vsprsortkeys = Z_Realloc(vsprsortkeys, vsprsortsize * sizeof (*vsprsortkeys), PU_STATIC, NULL);
+		vsprsorttemp = Z_Realloc(vsprsorttemp, vsprsortsize * sizeof (*vsprsorttemp), PU_STATIC, NULL);
+	}
 
-	// The first's prev and last's next will be set to
-	// nonsense, but are fixed in a moment
-	for (i = 0, dsnext = dsfirst, ds = NULL; i < visspritecount; i++)
+	// Gather the sprites that are still visible after clipping.
+	// Flipping the sign bits lets the signed fields sort as unsigned bytes.
+	for (i = 0, count = 0; i < visspritecount; i++)
 	{
-		dsprev = ds;
-		ds = dsnext;
-		if (i < visspritecount - 1) dsnext = R_GetVisSprite(i + 1);
+		ds = R_GetVisSprite(i);
 
-		ds->next = dsnext;
-		ds->prev = dsprev;
+		if (ds->cut & SC_NOTVISIBLE)
+			continue;
+
+		vsprsortkeys[count].key = ((UINT64)((UINT32)ds->sortscale ^ 0x80000000u) << 32)
+			| ((UINT32)ds->dispoffset ^ 0x80000000u);
+		vsprsortkeys[count].spr = ds;
+		differ |= vsprsortkeys[count].key ^ vsprsortkeys[0].key;
+		count++;
 	}
 
-	// Fix first and last. ds still points to the last one after the loop
-	dsfirst->prev = &unsorted;
-	unsorted.next = dsfirst;
-	if (ds)
-		ds->next = &unsorted;
-	unsorted.prev = ds;
+	src = vsprsortkeys;
+	dst = vsprsorttemp;
 
-	// pull the vissprites out by scale
-	vsprsortedhead.next = vsprsortedhead.prev = &vsprsortedhead;
-	for (i = 0; i < visspritecount; i++)
+	for (shift = 0; shift < 64; shift += 8)
 	{
-		bestscale = bestdispoffset = INT32_MAX;
-		for (ds = unsorted.next; ds != &unsorted; ds = ds->next)
-		{
-			// Remove this sprite if it was determined to not be visible
-			if (ds->cut & SC_NOTVISIBLE)
-			{
-				ds->next->prev = ds->prev;
-				ds->prev->next = ds->next;
-				continue;
-			}
+		if (!((differ >> shift) & 0xFF))
+			continue;
 
-			if (ds->sortscale < bestscale)
-			{
-				bestscale = ds->sortscale;
-				bestdispoffset = ds->dispoffset;
-				best = ds;
-			}
-			// order visprites of same scale by dispoffset, smallest first
-			else if (ds->sortscale == bestscale && ds->dispoffset < bestdispoffset)
-			{
-				bestdispoffset = ds->dispoffset;
-				best = ds;
-			}
-		}
-		if (best)
+		memset(counts, 0, sizeof (counts));
+		for (i = 0; i < count; i++)
+			counts[(src[i].key >> shift) & 0xFF]++;
+
+		for (i = 0, pos = 0; i < 256; i++)
 		{
-			best->next->prev = best->prev;
-			best->prev->next = best->next;
-			best->next = &vsprsortedhead;
-			best->prev = vsprsortedhead.prev;
-			vsprsortedhead.prev->next = best;
-			vsprsortedhead.prev = best;
+			digit = counts[i];
+			counts[i] = pos;
+			pos += digit;
 		}
+
+		for (i = 0; i < count; i++)
+			dst[counts[(src[i].key >> shift) & 0xFF]++] = src[i];
+
+		swap = src;
+		src = dst;
+		dst = swap;
+	}
+
+	for (i = 0; i < count; i++)
+	{
+		ds = src[i].spr;
+		ds->next = &vsprsortedhead;
+		ds->prev = vsprsortedhead.prev;
+		vsprsortedhead.prev->next = ds;
+		vsprsortedhead.prev = ds;
 	}
 }
 
@@ -2189,7 +2256,10 @@ static void R_CreateDrawNodes(void)
 	if (visspritecount == 0)
 		return;
 
+	PS_START_TIMING(ps_sw_spritesorttime);
 	R_SortVisSprites();
+	PS_STOP_TIMING(ps_sw_spritesorttime);
+
 	for (rover = vsprsortedhead.prev; rover != &vsprsortedhead; rover = rover->prev)
 	{
 		if (rover->szt > vid.height || rover->sz < 0)
@@ -2462,6 +2532,48 @@ static boolean R_CheckSpriteVisible(vissprite_t *spr, INT32 x1, INT32 x2)
 	return false;
 }
 
+// Returns which of ds's silhouettes clip spr, 0 if it doesn't
+static INT32 R_DrawsegClipsSprite(const drawseg_t *ds, const vissprite_t *spr)
+{
+	fixed_t scale, lowscale;
+	INT32 silhouette;
+
+	if (ds->portalpass > 0 && ds->portalpass <= portalrender)
+		return 0; // is a portal
+
+	if (ds->scale1 > ds->scale2)
+	{
+		lowscale = ds->scale2;
+		scale = ds->scale1;
+	}
+	else
+	{
+		lowscale = ds->scale1;
+		scale = ds->scale2;
+	}
+
+	if (scale < spr->sortscale ||
+	    (lowscale < spr->sortscale &&
+	     !R_PointOnSegSide (spr->gx, spr->gy, ds->curline)))
+	{
+		// masked mid texture?
+		/*if (ds->maskedtexturecol)
+			R_RenderMaskedSegRange (ds, r1, r2);*/
+		// seg is behind sprite
+		return 0;
+	}
+
+	silhouette = ds->silhouette;
+
+	if (spr->gz >= ds->bsilheight)
+		silhouette &= ~SIL_BOTTOM;
+
+	if (spr->gzt <= ds->tsilheight)
+		silhouette &= ~SIL_TOP;
+
+	return silhouette;
+}
+
 // R_ClipVisSprite
 // Clips vissprites without drawing, so that portals can work. -Red
 static void R_ClipVisSprite(vissprite_t *spr, INT32 x1, INT32 x2)
@@ -2470,8 +2582,6 @@ static void R_ClipVisSprite(vissprite_t *spr, INT32 x1, INT32 x2)
 	INT32		x;
 	INT32		r1;
 	INT32		r2;
-	fixed_t		scale;
-	fixed_t		lowscale;
 	INT32		silhouette;
 
 	for (x = x1; x <= x2; x++)
@@ -2487,82 +2597,76 @@ static void R_ClipVisSprite(vissprite_t *spr, INT32 x1, INT32 x2)
 	// and buggy, by going past LEFT end of array:
 
 	// e6y: optimization
-	if (drawsegs_xrange_size)
+	if (drawsegs_tilecount)
 	{
-		const drawseg_xrange_item_t *last = &drawsegs_xrange[drawsegs_xrange_count - 1];
-		drawseg_xrange_item_t *curr = &drawsegs_xrange[-1];
+		const INT32 t1 = max(spr->x1 >> drawsegs_tileshift, 0);
+		const INT32 t2 = min(spr->x2 >> drawsegs_tileshift, drawsegs_tilecount - 1);
+		const drawseg_xrange_item_t *curr, *last;
+		INT32 t, tx1, tx2, dsnum;
 
-		while (++curr <= last)
+		if (++drawsegs_curstamp == 0)
 		{
-			// determine if the drawseg obscures the sprite
-			if (curr->x1 > spr->x2 || curr->x2 < spr->x1)
-			{
-				// does not cover sprite
-				continue;
-			}
-
-			ds = curr->user;
-
-			if (ds->portalpass > 0 && ds->portalpass <= portalrender)
-				continue; // is a portal
+			memset(drawsegs_clipstamp, 0, drawsegs_clip_size * sizeof (*drawsegs_clipstamp));
+			drawsegs_curstamp = 1;
+		}
 
-			r1 = ds->x1 < spr->x1 ? spr->x1 : ds->x1;
-			r2 = ds->x2 > spr->x2 ? spr->x2 : ds->x2;
+		for (t = t1; t <= t2; t++)
+		{
+			tx1 = max(spr->x1, t << drawsegs_tileshift);
+			tx2 = min(spr->x2, ((t + 1) << drawsegs_tileshift) - 1);
+			curr = &drawsegs_tileitems[drawsegs_tilestart[t]];
+			last = &drawsegs_tileitems[drawsegs_tilestart[t + 1]];
 
-			if (ds->scale1 > ds->scale2)
+			for (; curr < last; curr++)
 			{
-				lowscale = ds->scale2;
-				scale = ds->scale1;
-			}
-			else
-			{
-				lowscale = ds->scale1;
-				scale = ds->scale2;
-			}
+				// determine if the drawseg obscures the sprite
+				if (curr->x1 > tx2 || curr->x2 < tx1)
+				{
+					// does not cover sprite
+					continue;
+				}
 
-			if (scale < spr->sortscale ||
-			    (lowscale < spr->sortscale &&
-			     !R_PointOnSegSide (spr->gx, spr->gy, ds->curline)))
-			{
-				// masked mid texture?
-				/*if (ds->maskedtexturecol)
-					R_RenderMaskedSegRange (ds, r1, r2);*/
-				// seg is behind sprite
-				continue;
-			}
+				ps_sw_drawsegtests.value.i++;
 
-			// clip this piece of the sprite
-			silhouette = ds->silhouette;
+				ds = curr->user;
+				dsnum = ds - drawsegs;
 
-			if (spr->gz >= ds->bsilheight)
-				silhouette &= ~SIL_BOTTOM;
+				if (drawsegs_clipstamp[dsnum] != drawsegs_curstamp)
+				{
+					drawsegs_clipstamp[dsnum] = drawsegs_curstamp;
+					drawsegs_clipsil[dsnum] = R_DrawsegClipsSprite(ds, spr);
+				}
 
-			if (spr->gzt <= ds->tsilheight)
-				silhouette &= ~SIL_TOP;
+				// clip this piece of the sprite
+				silhouette = drawsegs_clipsil[dsnum];
 
-			if (silhouette == SIL_BOTTOM)
-			{
-				// bottom sil
-				for (x = r1; x <= r2; x++)
-					if (spr->clipbot[x] == -2)
-						spr->clipbot[x] = ds->sprbottomclip[x];
-			}
-			else if (silhouette == SIL_TOP)
-			{
-				// top sil
-				for (x = r1; x <= r2; x++)
-					if (spr->cliptop[x] == -2)
-						spr->cliptop[x] = ds->sprtopclip[x];
-			}
-			else if (silhouette == (SIL_TOP|SIL_BOTTOM))
-			{
-				// both
-				for (x = r1; x <= r2; x++)
+				r1 = curr->x1 < tx1 ? tx1 : curr->x1;
+				r2 = curr->x2 > tx2 ? tx2 : curr->x2;
+
+				if (silhouette == SIL_BOTTOM)
 				{
-					if (spr->clipbot[x] == -2)
-						spr->clipbot[x] = ds->sprbottomclip[x];
-					if (spr->cliptop[x] == -2)
-						spr->cliptop[x] = ds->sprtopclip[x];
+					// bottom sil
+					for (x = r1; x <= r2; x++)
+						if (spr->clipbot[x] == -2)
+							spr->clipbot[x] = ds->sprbottomclip[x];
+				}
+				else if (silhouette == SIL_TOP)
+				{
+					// top sil
+					for (x = r1; x <= r2; x++)
+						if (spr->cliptop[x] == -2)
+							spr->cliptop[x] = ds->sprtopclip[x];
+				}
+				else if (silhouette == (SIL_TOP|SIL_BOTTOM))
+				{
+					// both
+					for (x = r1; x <= r2; x++)
+					{
+						if (spr->clipbot[x] == -2)
+							spr->clipbot[x] = ds->sprbottomclip[x];
+						if (spr->cliptop[x] == -2)
+							spr->cliptop[x] = ds->sprtopclip[x];
+					}
 				}
 			}
 		}
@@ -2660,62 +2764,77 @@ static void R_ClipVisSprite(vissprite_t *spr, INT32 x1, INT32 x2)
 void R_ClipSprites(void)
 {
 	const size_t maxdrawsegs = ds_p - drawsegs;
-	const INT32 cx = viewwidth / 2;
+	INT32 tilefill[DS_MAXTILES];
 	drawseg_t* ds;
-	INT32 i;
+	size_t numitems;
+	INT32 i, t1, t2;
 
 	// e6y
 	// Reducing of cache misses in the following R_DrawSprite()
 	// Makes sense for scenes with huge amount of drawsegs.
 	// ~12% of speed improvement on epic.wad map05
-	for (i = 0; i < DS_RANGES_COUNT; i++)
-	{
-		drawsegs_xranges[i].count = 0;
-	}
+	drawsegs_tilecount = 0;
 
 	if (visspritecount - clippedvissprites <= 0)
 	{
 		return;
 	}
 
-	if (drawsegs_xrange_size < maxdrawsegs)
+	if (drawsegs_clip_size < maxdrawsegs)
 	{
-		drawsegs_xrange_size = 2 * maxdrawsegs;
+		drawsegs_clip_size = 2 * maxdrawsegs;
+		drawsegs_clipstamp = Z_Realloc(drawsegs_clipstamp, drawsegs_clip_size * sizeof (*drawsegs_clipstamp), PU_STATIC, NULL);
+		drawsegs_clipsil = Z_Realloc(drawsegs_clipsil, drawsegs_clip_size * sizeof (*drawsegs_clipsil), PU_STATIC, NULL);
+		memset(drawsegs_clipstamp, 0, drawsegs_clip_size * sizeof (*drawsegs_clipstamp));
+	}
+
+	for (drawsegs_tileshift = DS_MINTILESHIFT; ((viewwidth - 1) >> drawsegs_tileshift) >= DS_MAXTILES; drawsegs_tileshift++)
+		;
 
-		for (i = 0; i < DS_RANGES_COUNT; i++)
+	// Count the drawsegs in each tile...
+	memset(tilefill, 0, sizeof (tilefill));
+	numitems = 0;
+
+	for (ds = ds_p; ds-- > drawsegs;)
+	{
+		if (ds->silhouette || ds->maskedtexturecol)
 		{
-			drawsegs_xranges[i].items = Z_Realloc(
-				drawsegs_xranges[i].items,
-				drawsegs_xrange_size * sizeof(drawsegs_xranges[i].items[0]),
-				PU_STATIC, NULL
-			);
+			t1 = max(ds->x1 >> drawsegs_tileshift, 0);
+			t2 = min(ds->x2 >> drawsegs_tileshift, DS_MAXTILES - 1);
+			for (i = t1; i <= t2; i++)
+				tilefill[i]++;
+			numitems += t2 - t1 + 1;
 		}
 	}
 
+	if (drawsegs_tileitems_size < numitems)
+	{
+		drawsegs_tileitems_size = 2 * numitems;
+		drawsegs_tileitems = Z_Realloc(drawsegs_tileitems, drawsegs_tileitems_size * sizeof (*drawsegs_tileitems), PU_STATIC, NULL);
+	}
+
+	drawsegs_tilecount = ((viewwidth - 1) >> drawsegs_tileshift) + 1;
+	drawsegs_tilestart[0] = 0;
+	for (i = 0; i < DS_MAXTILES; i++)
+	{
+		drawsegs_tilestart[i + 1] = drawsegs_tilestart[i] + tilefill[i];
+		tilefill[i] = drawsegs_tilestart[i];
+	}
+
+	// ...then list them, latest first
 	for (ds = ds_p; ds-- > drawsegs;)
 	{
 		if (ds->silhouette || ds->maskedtexturecol)
 		{
-			drawsegs_xranges[0].items[drawsegs_xranges[0].count].x1 = ds->x1;
-			drawsegs_xranges[0].items[drawsegs_xranges[0].count].x2 = ds->x2;
-			drawsegs_xranges[0].items[drawsegs_xranges[0].count].user = ds;
-
-			// e6y: ~13% of speed improvement on sunder.wad map10
-			if (ds->x1 < cx)
+			t1 = max(ds->x1 >> drawsegs_tileshift, 0);
+			t2 = min(ds->x2 >> drawsegs_tileshift, DS_MAXTILES - 1);
+			for (i = t1; i <= t2; i++)
 			{
-				drawsegs_xranges[1].items[drawsegs_xranges[1].count] =
-					drawsegs_xranges[0].items[drawsegs_xranges[0].count];
-				drawsegs_xranges[1].count++;
+				drawseg_xrange_item_t *item = &drawsegs_tileitems[tilefill[i]++];
+				item->x1 = ds->x1;
+				item->x2 = ds->x2;
+				item->user = ds;
 			}
-
-			if (ds->x2 >= cx)
-			{
-				drawsegs_xranges[2].items[drawsegs_xranges[2].count] =
-					drawsegs_xranges[0].items[drawsegs_xranges[0].count];
-				drawsegs_xranges[2].count++;
-			}
-
-			drawsegs_xranges[0].count++;
 		}
 	}
 
@@ -2730,23 +2849,8 @@ void R_ClipSprites(void)
 			continue;
 		}
 
-		if (spr->x2 < cx)
-		{
-			drawsegs_xrange = drawsegs_xranges[1].items;
-			drawsegs_xrange_count = drawsegs_xranges[1].count;
-		}
-		else if (spr->x1 >= cx)
-		{
-			drawsegs_xrange = drawsegs_xranges[2].items;
-			drawsegs_xrange_count = drawsegs_xranges[2].count;
-		}
-		else
-		{
-			drawsegs_xrange = drawsegs_xranges[0].items;
-			drawsegs_xrange_count = drawsegs_xranges[0].count;
-		}
-
 		R_ClipVisSprite(spr, spr->x1, spr->x2);
+		ps_sw_clippedsprites.value.i++;
 
 		if ((spr->cut & SC_NOTVISIBLE) == 0)
 			numvisiblesprites++;
@@ -3544,7 +3648,8 @@ next_token:
 			// So just let the function in the while loop take care of it for us.
 		}
 
-		R_FlushTranslationColormapCache();
+		// Anything cached for this slot before it was loaded is wrong now
+		R_UpdateTranslationColormaps(local ? numlocalskins : numskins, local);
 
 		CONS_Printf(M_GetText("Added skin '%s'\n"), skin->name);
 #ifdef SKINVALUES
@@ -45,6 +45,13 @@ void (*transcolfunc)(void); // translation column drawer
 void (*shadecolfunc)(void); // smokie test..
 void (*spanfunc)(void); // span drawer, use a 64x64 tile
 void (*splatfunc)(void); // span drawer w/ transparency
+void (*transspanfunc)(void); // translucent span drawer
+void (*tiltedspanfunc)(void); // sloped span drawer
+void (*tiltedtransspanfunc)(void); // translucent sloped span drawer
+void (*tiltedsplatfunc)(void); // sloped span drawer w/ transparency
+#ifndef NOWATER
+void (*tiltedwaterspanfunc)(void); // translucent sloped water span drawer
+#endif
 void (*basespanfunc)(void); // default span func for color mode
 void (*transtransfunc)(void); // translucent translated column drawer
 void (*twosmultipatchfunc)(void); // for cols with transparent pixels
@@ -78,6 +85,11 @@ static void Highreshudscale_OnChange(void)
 		SCR_Recalc();
 }
 
+#ifdef VECTORDRAWERS
+static void SCR_SetSpanDrawers(void);
+consvar_t cv_vectordrawers = {"vectordrawers", "On", CV_SAVE|CV_CALL|CV_NOINIT, CV_OnOff, SCR_SetSpanDrawers, 0, NULL, NULL, 0, 0, NULL};
+#endif
+
 static void SCR_ChangeFullscreen (void);
 
 consvar_t cv_fullscreen = {"fullscreen", "Yes", CV_SAVE|CV_CALL, CV_YesNo, SCR_ChangeFullscreen, 0, NULL, NULL, 0, 0, NULL};
@@ -97,6 +109,48 @@ UINT8 *scr_borderpatch; // flat used to fill the reduced view borders set at ST_
 //  Short and Tall sky drawer, for the current color mode
 void (*walldrawerfunc)(void);
 
+// Picks the 8bpp span drawers, the vector ones if the build has them and they're enabled,
+// and the AVX2 flat span drawers on top of those if the CPU has it
+static void SCR_SetSpanDrawers(void)
+{
+#ifdef VECTORDRAWERS
+	if (cv_vectordrawers.value)
+	{
+#ifdef VECTORDRAWERS_AVX2
+		if (R_HasAVX2())
+		{
+			spanfunc = basespanfunc = R_DrawSpan_8_AVX2;
+			splatfunc = R_DrawSplat_8_AVX2;
+			transspanfunc = R_DrawTranslucentSpan_8_AVX2;
+		}
+		else
+#endif
+		{
+			spanfunc = basespanfunc = R_DrawSpan_8_Vector;
+			splatfunc = R_DrawSplat_8_Vector;
+			transspanfunc = R_DrawTranslucentSpan_8_Vector;
+		}
+		tiltedspanfunc = R_DrawTiltedSpan_8_Vector;
+		tiltedtransspanfunc = R_DrawTiltedTranslucentSpan_8_Vector;
+		tiltedsplatfunc = R_DrawTiltedSplat_8_Vector;
+#ifndef NOWATER
+		tiltedwaterspanfunc = R_DrawTiltedTranslucentWaterSpan_8_Vector;
+#endif
+		return;
+	}
+#endif
+
+	spanfunc = basespanfunc = R_DrawSpan_8;
+	splatfunc = R_DrawSplat_8;
+	transspanfunc = R_DrawTranslucentSpan_8;
+	tiltedspanfunc = R_DrawTiltedSpan_8;
+	tiltedtransspanfunc = R_DrawTiltedTranslucentSpan_8;
+	tiltedsplatfunc = R_DrawTiltedSplat_8;
+#ifndef NOWATER
+	tiltedwaterspanfunc = R_DrawTiltedTranslucentWaterSpan_8;
+#endif
+}
+
 void SCR_SetMode(void)
 {
 	if (dedicated)
@@ -114,8 +168,7 @@ void SCR_SetMode(void)
 	//
 	if (true)//vid.bpp == 1) //Always run in 8bpp. todo: remove all 16bpp code?
 	{
-		spanfunc = basespanfunc = R_DrawSpan_8;
-		splatfunc = R_DrawSplat_8;
+		SCR_SetSpanDrawers();
 		transcolfunc = R_DrawTranslatedColumn_8;
 		transtransfunc = R_DrawTranslatedTranslucentColumn_8;
 
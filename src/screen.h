@@ -130,6 +130,13 @@ extern void (*shadecolfunc)(void);
 extern void (*spanfunc)(void);
 extern void (*basespanfunc)(void);
 extern void (*splatfunc)(void);
+extern void (*transspanfunc)(void);
+extern void (*tiltedspanfunc)(void);
+extern void (*tiltedtransspanfunc)(void);
+extern void (*tiltedsplatfunc)(void);
+#ifndef NOWATER
+extern void (*tiltedwaterspanfunc)(void);
+#endif
 extern void (*transtransfunc)(void);
 extern void (*twosmultipatchfunc)(void);
 extern void (*twosmultipatchtransfunc)(void);
@@ -145,6 +152,9 @@ extern INT32 scr_bpp;
 extern UINT8 *scr_borderpatch; // patch used to fill the view borders
 
 extern consvar_t cv_scr_width, cv_scr_height, cv_scr_depth, cv_renderview, cv_fullscreen, cv_vhseffect, cv_shittyscreen;
+#ifdef VECTORDRAWERS
+extern consvar_t cv_vectordrawers;
+#endif
 extern consvar_t cv_highreshudscale;
 // wait for page flipping to end or not
 extern consvar_t cv_vidwait;
@@ -21,6 +21,9 @@
 
 #include <stdlib.h>
 #include <errno.h>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
 
 #include <signal.h>
 
@@ -77,6 +80,8 @@
 #include "sdlmain.h"
 #include "../i_system.h"
 #include "../hu_stuff.h" // for chat_on
+#include "../r_main.h" // cv_renderthreads, ps_sw_presenttime
+#include "../i_threads.h"
 #ifdef HWRENDER
 #include "../hardware/hw_main.h"
 #include "../hardware/hw_drv.h"
@@ -1655,10 +1660,234 @@ static inline boolean I_SkipFrame(void)
 }
 
 //
-// I_FinishUpdate
+// Present
+//
+// Expands the 8-bit screen through the palette straight into the locked
+// streaming texture. Each palette entry is mapped to the texture's pixel
+// format once, so a pixel costs one table lookup, and with renderthreads
+// above 1 the rows are split between threads.
 //
 static SDL_Rect src_rect = { 0, 0, 0, 0 };
 
+static Uint32 presentpalette[256];
+static Uint32 presentformat; // format presentpalette was mapped for, 0 when stale
+
+typedef struct
+{
+	UINT8 *dest;
+	int pitch;
+	int bytespp;
+	INT32 y1, y2;
+} presentjob_t;
+
+static void Impl_ExpandRows(const presentjob_t *job)
+{
+	const INT32 width = vid.width;
+	const Uint32 *pal = presentpalette;
+	INT32 x, y;
+
+	for (y = job->y1; y < job->y2; y++)
+	{
+		const UINT8 *src = screens[0] + y*vid.rowbytes;
+		UINT8 *dest = job->dest + y*job->pitch;
+
+		x = 0;
+		if (job->bytespp == 4)
+		{
+			Uint32 *d = (Uint32 *)dest;
+#ifdef __AVX2__
+			for (; x + 8 <= width; x += 8)
+			{
+				__m128i idx = _mm_loadl_epi64((const __m128i *)(src + x));
+				_mm256_storeu_si256((__m256i *)(d + x),
+					_mm256_i32gather_epi32((const int *)pal, _mm256_cvtepu8_epi32(idx), 4));
+			}
+#endif
+			for (; x + 4 <= width; x += 4)
+			{
+				d[x] = pal[src[x]];
+				d[x+1] = pal[src[x+1]];
+				d[x+2] = pal[src[x+2]];
+				d[x+3] = pal[src[x+3]];
+			}
+			for (; x < width; x++)
+				d[x] = pal[src[x]];
+		}
+		else
+		{
+			Uint16 *d = (Uint16 *)dest;
+			for (; x + 4 <= width; x += 4)
+			{
+				d[x] = (Uint16)pal[src[x]];
+				d[x+1] = (Uint16)pal[src[x+1]];
+				d[x+2] = (Uint16)pal[src[x+2]];
+				d[x+3] = (Uint16)pal[src[x+3]];
+			}
+			for (; x < width; x++)
+				d[x] = (Uint16)pal[src[x]];
+		}
+	}
+}
+
+#ifdef HAVE_THREADS
+static presentjob_t presentjobs[MAXRENDERTHREADS];
+static INT32 numpresentjobs;
+
+static I_mutex presentthread_mutex;
+static I_cond presentthread_cond; // workers wait here for rows
+static I_cond presentthread_donecond; // and Impl_ExpandScreen waits here for them
+static UINT32 presentthread_generation;
+static INT32 presentthread_pending;
+static INT32 presentthread_spawned;
+static INT32 presentthread_running; // workers that haven't returned yet
+static boolean presentthread_quit;
+
+typedef struct
+{
+	INT32 id;
+	UINT32 generation; // the frame before it was spawned, which it isn't part of
+} presentthreadarg_t;
+
+static presentthreadarg_t presentthreadargs[MAXRENDERTHREADS];
+
+static void Impl_PresentThread(void *userdata)
+{
+	const presentthreadarg_t *arg = userdata;
+	const INT32 id = arg->id;
+	UINT32 generation = arg->generation;
+	boolean expand;
+
+	for (;;)
+	{
+		I_lock_mutex(&presentthread_mutex);
+		while (presentthread_generation == generation && !presentthread_quit)
+			I_hold_cond(&presentthread_cond, presentthread_mutex);
+
+		if (presentthread_quit)
+		{
+			if (--presentthread_running == 0)
+				I_wake_all_cond(&presentthread_donecond);
+			I_unlock_mutex(presentthread_mutex);
+			return;
+		}
+
+		generation = presentthread_generation;
+		expand = (id < numpresentjobs);
+		I_unlock_mutex(presentthread_mutex);
+
+		if (expand)
+			Impl_ExpandRows(&presentjobs[id]);
+
+		I_lock_mutex(&presentthread_mutex);
+		if (--presentthread_pending == 0)
+			I_wake_all_cond(&presentthread_donecond);
+		I_unlock_mutex(presentthread_mutex);
+	}
+}
+
+static void Impl_StopPresentThreads(void)
+{
+	I_lock_mutex(&presentthread_mutex);
+	presentthread_quit = true;
+	I_wake_all_cond(&presentthread_cond);
+
+	// The screen goes away after this, so wait for them.
+	while (presentthread_running)
+		I_hold_cond(&presentthread_donecond, presentthread_mutex);
+	I_unlock_mutex(presentthread_mutex);
+}
+#endif
+
+static void Impl_ExpandScreen(UINT8 *dest, int pitch, int bytespp)
+{
+	presentjob_t job;
+
+	job.dest = dest;
+	job.pitch = pitch;
+	job.bytespp = bytespp;
+	job.y1 = 0;
+	job.y2 = vid.height;
+
+#ifdef HAVE_THREADS
+	if (cv_renderthreads.value > 1)
+	{
+		const INT32 count = cv_renderthreads.value;
+		INT32 i;
+
+		if (!presentthread_spawned)
+			I_AddExitFunc(Impl_StopPresentThreads);
+
+		// Threads stay around once started; extra ones just skip their turn.
+		// A new one has to wait for the next frame, not run on this one's
+		// rows while they're still being set up.
+		I_lock_mutex(&presentthread_mutex);
+		for (; presentthread_spawned < count-1; presentthread_spawned++)
+		{
+			presentthreadarg_t *arg = &presentthreadargs[presentthread_spawned+1];
+			arg->id = presentthread_spawned+1;
+			arg->generation = presentthread_generation;
+			presentthread_running++;
+			I_spawn_thread("present", Impl_PresentThread, arg);
+		}
+		I_unlock_mutex(presentthread_mutex);
+
+		for (i = 0; i < count; i++)
+		{
+			presentjobs[i] = job;
+			presentjobs[i].y1 = vid.height * i / count;
+			presentjobs[i].y2 = vid.height * (i+1) / count;
+		}
+
+		I_lock_mutex(&presentthread_mutex);
+		numpresentjobs = count;
+		presentthread_pending = presentthread_spawned;
+		presentthread_generation++;
+		I_wake_all_cond(&presentthread_cond);
+		I_unlock_mutex(presentthread_mutex);
+
+		Impl_ExpandRows(&presentjobs[0]);
+
+		I_lock_mutex(&presentthread_mutex);
+		while (presentthread_pending)
+			I_hold_cond(&presentthread_donecond, presentthread_mutex);
+		I_unlock_mutex(presentthread_mutex);
+		return;
+	}
+#endif
+
+	Impl_ExpandRows(&job);
+}
+
+// Returns false if the texture couldn't be written to directly.
+static boolean Impl_PresentScreen(void)
+{
+	const SDL_PixelFormat *format = vidSurface->format;
+	void *pixels;
+	int pitch;
+	size_t i;
+
+	if (vid.bpp != 1 || (format->BytesPerPixel != 2 && format->BytesPerPixel != 4))
+		return false;
+
+	if (presentformat != format->format)
+	{
+		for (i = 0; i < 256; i++)
+			presentpalette[i] = SDL_MapRGB(format, localPalette[i].r, localPalette[i].g, localPalette[i].b);
+		presentformat = format->format;
+	}
+
+	if (SDL_LockTexture(texture, &src_rect, &pixels, &pitch) != 0)
+		return false;
+
+	Impl_ExpandScreen(pixels, pitch, format->BytesPerPixel);
+	SDL_UnlockTexture(texture);
+	return true;
+}
+
+//
+// I_FinishUpdate
+//
+
 void I_FinishUpdate(void)
 {
 	if (rendermode == render_none)
@@ -1687,7 +1916,8 @@ void I_FinishUpdate(void)
 			Impl_VideoSetupSDLBuffer();
 		}
 
-		if (bufSurface)
+		PS_START_TIMING(ps_sw_presenttime);
+		if (bufSurface && !Impl_PresentScreen())
 		{
 			SDL_BlitSurface(bufSurface, &src_rect, vidSurface, &src_rect);
 			// Fury -- there's no way around UpdateTexture, the GL backend uses it anyway
@@ -1695,6 +1925,7 @@ void I_FinishUpdate(void)
 			SDL_UpdateTexture(texture, &src_rect, vidSurface->pixels, vidSurface->pitch);
 			SDL_UnlockSurface(vidSurface);
 		}
+		PS_STOP_TIMING(ps_sw_presenttime);
 
 		SDL_RenderClear(renderer);
 		SDL_RenderCopy(renderer, texture, &src_rect, NULL);
@@ -1747,6 +1978,7 @@ void I_SetPalette(RGBA_t *palette)
 		localPalette[i].g = palette[i].s.green;
 		localPalette[i].b = palette[i].s.blue;
 	}
+	presentformat = 0;
 	//if (vidSurface) SDL_SetPaletteColors(vidSurface->format->palette, localPalette, 0, 256);
 	// Fury -- SDL2 vidSurface is a 32-bit surface buffer copied to the texture. It's not palletized, like bufSurface.
 	if (bufSurface) SDL_SetPaletteColors(bufSurface->format->palette, localPalette, 0, 256);
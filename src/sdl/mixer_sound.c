@@ -247,6 +247,27 @@ void I_ShutdownSound(void)
 #endif
 }
 
+static void (*audiocapture)(const INT16 *samples, size_t numsamples) = NULL;
+
+static void audio_capture(void *udata, Uint8 *stream, int len)
+{
+	(void)udata;
+	audiocapture((const INT16 *)stream, (size_t)len / sizeof (INT16));
+}
+
+INT32 I_SetAudioCapture(void (*func)(const INT16 *samples, size_t numsamples))
+{
+	if (!sound_started)
+		return 0;
+
+	// Unhook first, so the audio thread never sees a half-changed pointer.
+	Mix_SetPostMix(NULL, NULL);
+	audiocapture = func;
+	if (func)
+		Mix_SetPostMix(audio_capture, NULL);
+	return SAMPLERATE;
+}
+
 void I_UpdateSound(void)
 {
 	if (fading_do_callback)
@@ -1167,6 +1167,12 @@ void I_UpdateSound(void)
 {
 }
 
+INT32 I_SetAudioCapture(void (*func)(const INT16 *samples, size_t numsamples))
+{
+	(void)func;
+	return 0;
+}
+
 void I_StartupSound(void)
 {
 #ifdef HW3SOUND
@@ -441,6 +441,9 @@ static void LoadPalette(const char *lumpname)
 		if (Cubeapply)
 			V_CubeApply(&pLocalPalette[i].s.red, &pLocalPalette[i].s.green, &pLocalPalette[i].s.blue);
 	}
+
+	// Rainbow colormaps match brightnesses in the palette
+	R_UpdateTranslationColormaps(TC_RAINBOW, false);
 }
 
 #ifdef BACKWARDSCOMPATCORRECTION